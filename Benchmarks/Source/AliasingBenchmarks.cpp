@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    AliasingBenchmarks.cpp
+
+    Antiderivative anti-aliasing against oversampling: for each saturator
+    curve and the two clippers, ns/sample through ClipSatEngine and the
+    signal-to-alias ratio of its output, with no anti-aliasing, first and
+    second order ADAA, and 2x to 8x oversampling.
+
+    The input is a loud sine whose frequency doesn't divide the sample rate,
+    so the harmonics the curve folds back past Nyquist land between the
+    ones below it. The signal-to-alias ratio is the power at the harmonics
+    below Nyquist over the power everywhere else, from a Blackman-Harris
+    windowed FFT of the output once it has settled. Higher is cleaner.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/ClipSatEngine.h"
+#include "../../Source/SaturationKernels.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr double testFrequency = 2489.7;
+    constexpr float amplitude = 1.5f;
+    constexpr int numChannels = 2;
+    constexpr int blockSize = 512;
+
+    constexpr int fftOrder = 15;
+    constexpr int fftSize = 1 << fftOrder;
+    constexpr int warmUpSamples = 16 * blockSize;   // Past the oversampling filters' settling
+    constexpr int harmonicHalfWidth = 4;            // Bins either side of a harmonic, the window's main lobe
+
+    struct Curve
+    {
+        const char* name;
+        int saturationMode;     // -1 for the saturator off
+        int clipper;            // 0 off, 1 hard, 2 soft
+        float drive;
+    };
+
+    const Curve curves[] =
+    {
+        { "Soft Sine",   SaturationKernels::softSine,   0, 4.0f },
+        { "Hard Curve",  SaturationKernels::hardCurve,  0, 1.0f },
+        { "Analog Clip", SaturationKernels::analogClip, 0, 1.0f },
+        { "Sinoid Fold", SaturationKernels::sinoidFold, 0, 4.0f },
+        { "Hard Clip",   -1,                            1, 1.0f },
+        { "Soft Clip",   -1,                            2, 1.0f }
+    };
+
+    struct Method
+    {
+        const char* name;
+        int oversamplingStages;
+        int antiAliasing;
+    };
+
+    const Method methods[] =
+    {
+        { "none",          0, AntiderivativeKernels::off },
+        { "ADAA 1st",      0, AntiderivativeKernels::firstOrder },
+        { "ADAA 2nd",      0, AntiderivativeKernels::secondOrder },
+        { "2x",            1, AntiderivativeKernels::off },
+        { "4x",            2, AntiderivativeKernels::off },
+        { "8x",            3, AntiderivativeKernels::off },
+        { "2x + ADAA 1st", 1, AntiderivativeKernels::firstOrder }
+    };
+
+    ParameterSnapshot createParams (const Curve& curve, const Method& method)
+    {
+        ParameterSnapshot params;
+        params.satOn = curve.saturationMode >= 0;
+        params.saturationMode = juce::jmax (0, curve.saturationMode);
+        params.drive = curve.drive;
+        params.dryWet = 1.0f;
+        params.clipperOn = curve.clipper != 0;
+        params.softClipping = curve.clipper == 2;
+        params.setThresholdDecibels (-6.0f);
+        params.oversamplingStages = method.oversamplingStages;
+        params.antiAliasing = method.antiAliasing;
+        params.accuracy = FastMath::Accuracy::accurate;
+        return params;
+    }
+
+    /** The power at the test tone's harmonics below Nyquist over the power in every
+        other bin, in dB.
+    */
+    double measureSignalToAlias (const float* output)
+    {
+        juce::HeapBlock<float> spectrum (2 * fftSize, true);
+        std::copy (output, output + fftSize, spectrum.get());
+
+        juce::dsp::WindowingFunction<float> window (static_cast<size_t> (fftSize), juce::dsp::WindowingFunction<float>::blackmanHarris, false);
+        window.multiplyWithWindowingTable (spectrum, static_cast<size_t> (fftSize));
+
+        juce::dsp::FFT fft (fftOrder);
+        fft.performFrequencyOnlyForwardTransform (spectrum);
+
+        const auto binWidth = sampleRate / fftSize;
+        double harmonicPower = 0.0, aliasPower = 0.0;
+
+        // The bins next to DC only hold the window's main lobe
+        for (int bin = harmonicHalfWidth + 1; bin <= fftSize / 2; ++bin)
+        {
+            const auto frequency = bin * binWidth;
+            const auto harmonic = std::round (frequency / testFrequency);
+            const auto power = static_cast<double> (spectrum[bin]) * spectrum[bin];
+
+            const bool isHarmonic = harmonic >= 1.0
+                                 && harmonic * testFrequency < 0.5 * sampleRate
+                                 && std::abs (frequency - harmonic * testFrequency) <= harmonicHalfWidth * binWidth;
+
+            (isHarmonic ? harmonicPower : aliasPower) += power;
+        }
+
+        return 10.0 * std::log10 (harmonicPower / juce::jmax (aliasPower, 1.0e-30));
+    }
+
+    void runCase (const Curve& curve, const Method& method)
+    {
+        const auto params = createParams (curve, method);
+        constexpr int numSamples = warmUpSamples + fftSize;
+
+        ClipSatEngine<float> engine;
+        engine.prepare (sampleRate, blockSize, numChannels, params);
+
+        juce::AudioBuffer<float> input (numChannels, numSamples), output (numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                input.setSample (channel, i, amplitude * static_cast<float> (std::sin (juce::MathConstants<double>::twoPi * testFrequency * i / sampleRate)));
+
+        // Each run starts the tone again, and the warm-up covers the jump
+        auto render = [&]
+        {
+            output.makeCopyOf (input, true);
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                float* channels[numChannels];
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    channels[channel] = output.getWritePointer (channel, start);
+
+                engine.process (channels, numChannels, blockSize, params);
+            }
+
+            Benchmark::sink = Benchmark::sink + output.getSample (0, numSamples - 1);
+        };
+
+        const auto ns = Benchmark::nanosecondsPerSample (render, numSamples, 5);
+        const auto signalToAlias = measureSignalToAlias (output.getReadPointer (0, warmUpSamples));
+
+        std::printf ("%-12s %-14s %10.3f %10.1f %8d\n", curve.name, method.name, ns, signalToAlias, engine.getLatencySamples());
+    }
+}
+
+//==============================================================================
+int runAliasingBenchmarks (const juce::StringArray&)
+{
+    std::printf ("\nAliasing: %.1f Hz sine at %.1f, %g Hz, %d channels, %d sample blocks, best of 5 runs\n",
+                 testFrequency, static_cast<double> (amplitude), sampleRate, numChannels, blockSize);
+    std::printf ("%-12s %-14s %10s %10s %8s\n", "curve", "method", "ns/sample", "SAR (dB)", "latency");
+
+    for (auto& curve : curves)
+        for (auto& method : methods)
+            runCase (curve, method);
+
+    return 0;
+}
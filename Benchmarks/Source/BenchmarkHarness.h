@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    BenchmarkHarness.h
+
+    Timing helpers shared by the benchmark suites.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <limits>
+
+namespace Benchmark
+{
+    /** Written to after every timed run so the optimiser can't drop the work. */
+    inline volatile float sink = 0.0f;
+
+    /** Runs fn a few times to warm up, then returns the best of numRuns timings
+        in nanoseconds per sample.
+    */
+    template <typename Fn>
+    double nanosecondsPerSample (Fn&& fn, int samplesPerRun, int numRuns = 25)
+    {
+        for (int i = 0; i < 3; ++i)
+            fn();
+
+        double best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            fn();
+            auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+            best = juce::jmin (best, elapsed);
+        }
+
+        return best * 1.0e9 / samplesPerRun;
+    }
+
+    /** Fills data with a sweep from -range to +range. */
+    inline void fillRamp (float* data, int numSamples, float range)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = range * (2.0f * static_cast<float> (i) / static_cast<float> (numSamples - 1) - 1.0f);
+    }
+}
+
+//==============================================================================
+// Suites, one per source file
+int runMathBenchmarks (const juce::StringArray& args);
+int runProcessingBenchmarks (const juce::StringArray& args);
+int runChainBenchmarks (const juce::StringArray& args);
+int runAliasingBenchmarks (const juce::StringArray& args);
+int runStateBenchmarks (const juce::StringArray& args);
+int runUndoBenchmarks (const juce::StringArray& args);
+int runMemoryBenchmarks (const juce::StringArray& args);
+int runDispatchBenchmarks (const juce::StringArray& args);
+int runSchedulerBenchmarks (const juce::StringArray& args);
@@ -0,0 +1,629 @@
+/*
+  ==============================================================================
+
+    ChainBenchmarks.cpp
+
+    ns/sample and real-time factor for ClipSatAudioProcessor::processBlock
+    across block sizes, channel counts, sample rates and every stage and mode
+    combination, plus the two situations where processBlock does extra work:
+    host automation, which keeps the smoothers ramping, and an attached
+    editor, which keeps the visualiser FIFOs draining so every push copies.
+    The "engine" cases time ClipSatEngine on its own, without the plugin
+    wrapper or its parameters, and the "bed" cases time a 12 channel bed
+    through one instance against the same channels split across six stereo
+    instances. The "idle" cases time an instance on a silent track and one
+    the host has bypassed, the states most instances spend most of their
+    time in, and the "voices" cases time the chorus from one voice to eight.
+    The "profiler" cases time processBlock with the profiler's per-stage
+    timing off, as the plugin runs unless its CPU readout is clicked, and
+    on, so the difference is what the stage timing costs.
+
+    Before timing anything, the suite checks that the chorus spread only
+    pans across a layout's stereo pairs: in 5.1, the centre and the LFE
+    must come out identical to each other, and the same at every spread,
+    or the suite fails.
+
+        ClipSatBenchmarks chain [--full] [--json <file>] [--label <text>]
+
+    By default each dimension is swept on its own around a common case;
+    --full runs every combination instead, which takes a long time. --json
+    writes every result to a file, with --label (a commit, say) to tell runs
+    apart when comparing them.
+
+    ns/sample is per sample frame, all channels (and instances) together, and
+    the real-time factor is processing time over audio time, so below 1 keeps
+    up.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr int samplesPerRun = 1 << 14;  // At least, rounded up to whole blocks
+    constexpr int numRuns = 9;
+
+    const char* const saturationModeNames[] = { "Soft Sine", "Hard Curve", "Analog Clip", "Sinoid Fold" };
+    const char* const clipperNames[] = { "off", "hard", "soft" };
+
+    struct Case
+    {
+        const char* group = "";
+        bool chorus = true;
+        int chorusVoices = 2;
+        int saturationMode = 0;     // -1 for the saturator off
+        int clipper = 2;            // Index into clipperNames
+        int blockSize = 512;
+        int numChannels = 2;        // In total, split evenly across the instances
+        int numInstances = 1;
+        double sampleRate = 48000.0;
+        bool automation = false;
+        bool editor = false;
+        bool engineOnly = false;    // ClipSatEngine::process instead of processBlock
+        bool silentInput = false;
+        bool bypassed = false;      // processBlockBypassed instead of processBlock
+        bool stageTiming = false;   // The profiler timing every stage, not just whole blocks
+
+        juce::String getStages() const
+        {
+            return (chorus ? "Chorus x" + juce::String (chorusVoices) + ", " : juce::String())
+                 + (saturationMode >= 0 ? saturationModeNames[saturationMode] : "no saturator")
+                 + ", clipper " + clipperNames[clipper];
+        }
+
+        int getChannelsPerInstance() const noexcept    { return numChannels / numInstances; }
+    };
+
+    struct Result
+    {
+        Case benchmark;
+        double nsPerSample = 0.0;
+
+        double getRealTimeFactor() const noexcept    { return nsPerSample * 1.0e-9 * benchmark.sampleRate; }
+    };
+
+    //==============================================================================
+    /** Sets a parameter the way a host's automation does: the new value, then its listeners. */
+    void setParameter (ClipSatAudioProcessor& processor, const char* parameterID, float value)
+    {
+        auto* parameter = processor.parameters.getParameter (parameterID);
+        const auto normalised = parameter->convertTo0to1 (value);
+
+        parameter->setValue (normalised);
+        parameter->sendValueChangedMessageToListeners (normalised);
+    }
+
+    std::unique_ptr<ClipSatAudioProcessor> createProcessor (const Case& benchmark)
+    {
+        auto processor = std::make_unique<ClipSatAudioProcessor>();
+
+        setParameter (*processor, "chorusOnOff", benchmark.chorus ? 1.0f : 0.0f);
+        setParameter (*processor, "chorusVoices", static_cast<float> (benchmark.chorusVoices));
+        setParameter (*processor, "satOnOff", benchmark.saturationMode >= 0 ? 1.0f : 0.0f);
+        setParameter (*processor, "saturationMode", static_cast<float> (juce::jmax (0, benchmark.saturationMode)));
+        setParameter (*processor, "clipperOnOff", benchmark.clipper != 0 ? 1.0f : 0.0f);
+        setParameter (*processor, "softClipping", benchmark.clipper == 2 ? 1.0f : 0.0f);
+        setParameter (*processor, "drive", 4.0f);
+
+        const auto channels = juce::AudioChannelSet::canonicalChannelSet (benchmark.getChannelsPerInstance());
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channels);
+        layout.outputBuses.add (channels);
+
+        if (! processor->setBusesLayout (layout))
+            return {};
+
+        processor->getProfiler().setStageTimingEnabled (benchmark.stageTiming);
+        processor->setRateAndBufferSizeDetails (benchmark.sampleRate, benchmark.blockSize);
+        processor->prepareToPlay (benchmark.sampleRate, benchmark.blockSize);
+        return processor;
+    }
+
+    /** A swept sine on every channel, loud enough to reach the clipper, or digital silence. */
+    juce::AudioBuffer<float> createInput (const Case& benchmark)
+    {
+        const auto numSamples = juce::jmax (1, samplesPerRun / benchmark.blockSize) * benchmark.blockSize;
+        juce::AudioBuffer<float> input (benchmark.numChannels, numSamples);
+
+        if (benchmark.silentInput)
+        {
+            input.clear();
+            return input;
+        }
+
+        for (int channel = 0; channel < benchmark.numChannels; ++channel)
+        {
+            auto* data = input.getWritePointer (channel);
+            double phase = 0.0;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                data[i] = 0.9f * static_cast<float> (std::sin (phase));
+                phase += juce::MathConstants<double>::twoPi * (100.0 + 4000.0 * i / numSamples + 30.0 * channel) / benchmark.sampleRate;
+            }
+        }
+
+        return input;
+    }
+
+    /** Every continuous parameter moves a little on every block, as a busy automation lane would. */
+    void automate (ClipSatAudioProcessor& processor, int blockIndex)
+    {
+        const auto position = static_cast<float> (std::sin (0.05 * blockIndex));
+
+        setParameter (processor, "inputGain", 1.0f + 0.2f * position);
+        setParameter (processor, "threshold", -6.0f + 3.0f * position);
+        setParameter (processor, "drive", 4.0f + 2.0f * position);
+        setParameter (processor, "dryWet", 0.5f + 0.3f * position);
+        setParameter (processor, "rate", 1.0f + 0.5f * position);
+        setParameter (processor, "depth", 0.1f + 0.05f * position);
+        setParameter (processor, "mix", 0.5f + 0.2f * position);
+        setParameter (processor, "tone", 4000.0f + 2000.0f * position);
+        setParameter (processor, "spread", 0.5f + 0.3f * position);
+        setParameter (processor, "outputGain", 1.0f - 0.2f * position);
+    }
+
+    /** Each instance processes its own share of the input's channels, one block after another. */
+    double timeCase (const juce::Array<ClipSatAudioProcessor*>& processors, const Case& benchmark)
+    {
+        jassert (processors.size() == benchmark.numInstances);
+
+        const auto input = createInput (benchmark);
+        const auto channelsPerInstance = benchmark.getChannelsPerInstance();
+        std::vector<juce::AudioBuffer<float>> blocks (static_cast<size_t> (benchmark.numInstances),
+                                                      juce::AudioBuffer<float> (channelsPerInstance, benchmark.blockSize));
+        juce::MidiBuffer midi;
+        int blockIndex = 0;
+
+        return Benchmark::nanosecondsPerSample ([&]
+        {
+            for (int start = 0; start < input.getNumSamples(); start += benchmark.blockSize)
+            {
+                for (int instance = 0; instance < benchmark.numInstances; ++instance)
+                {
+                    auto& processor = *processors.getUnchecked (instance);
+                    auto& block = blocks[static_cast<size_t> (instance)];
+
+                    for (int channel = 0; channel < channelsPerInstance; ++channel)
+                        block.copyFrom (channel, 0, input, instance * channelsPerInstance + channel, start, benchmark.blockSize);
+
+                    if (benchmark.automation)
+                        automate (processor, blockIndex);
+
+                    if (benchmark.bypassed)
+                        processor.processBlockBypassed (block, midi);
+                    else
+                        processor.processBlock (block, midi);
+                }
+
+                ++blockIndex;
+            }
+
+            Benchmark::sink = Benchmark::sink + blocks.front().getSample (0, benchmark.blockSize - 1);
+        }, input.getNumSamples(), numRuns);
+    }
+
+    /** The same settings as createProcessor() gives the processor, for the engine on its own. */
+    ClipSatEngine<float>::Params createParams (const Case& benchmark)
+    {
+        ClipSatEngine<float>::Params params;
+        params.drive = 4.0f;
+        params.dryWet = 0.5f;
+        params.depth = 0.1f;
+        params.mix = 0.5f;
+        params.setThresholdDecibels (-6.0f);
+        params.chorusOn = benchmark.chorus;
+        params.chorusVoices = benchmark.chorusVoices;
+        params.satOn = benchmark.saturationMode >= 0;
+        params.saturationMode = juce::jmax (0, benchmark.saturationMode);
+        params.clipperOn = benchmark.clipper != 0;
+        params.softClipping = benchmark.clipper == 2;
+        return params;
+    }
+
+    double timeEngine (const Case& benchmark)
+    {
+        const auto params = createParams (benchmark);
+        ClipSatEngine<float> engine;
+        engine.prepare (benchmark.sampleRate, benchmark.blockSize, benchmark.numChannels, params);
+
+        const auto input = createInput (benchmark);
+        juce::AudioBuffer<float> block (benchmark.numChannels, benchmark.blockSize);
+
+        return Benchmark::nanosecondsPerSample ([&]
+        {
+            for (int start = 0; start < input.getNumSamples(); start += benchmark.blockSize)
+            {
+                for (int channel = 0; channel < benchmark.numChannels; ++channel)
+                    block.copyFrom (channel, 0, input, channel, start, benchmark.blockSize);
+
+                engine.process (block.getArrayOfWritePointers(), benchmark.numChannels, benchmark.blockSize, params);
+            }
+
+            Benchmark::sink = Benchmark::sink + block.getSample (0, benchmark.blockSize - 1);
+        }, input.getNumSamples(), numRuns);
+    }
+
+    /** The same signal on every channel of a 5.1 layout through the chorus alone, at
+        several spreads and voice counts. Returns false if the centre and the LFE
+        differ from each other, or from the centre with no spread at all.
+    */
+    bool checkSurroundSpread()
+    {
+        constexpr int numSamples = 4096;
+        const auto layout = juce::AudioChannelSet::create5point1();
+        const auto centre = layout.getChannelIndexForType (juce::AudioChannelSet::centre);
+        const auto lfe = layout.getChannelIndexForType (juce::AudioChannelSet::LFE);
+        bool allMatch = true;
+
+        for (auto voices : { 2, 3, 8 })
+        {
+            juce::AudioBuffer<float> unspread;
+
+            for (auto spread : { 0.0f, 0.3f, 1.0f })
+            {
+                Case benchmark;
+                benchmark.chorusVoices = voices;
+                benchmark.saturationMode = -1;
+                benchmark.clipper = 0;
+
+                auto params = createParams (benchmark);
+                params.spread = spread;
+
+                ClipSatEngine<float> engine;
+                engine.prepare (48000.0, numSamples, layout.size(), params, layout);
+
+                juce::AudioBuffer<float> buffer (layout.size(), numSamples);
+
+                for (int channel = 0; channel < layout.size(); ++channel)
+                    for (int i = 0; i < numSamples; ++i)
+                        buffer.setSample (channel, i, 0.5f * static_cast<float> (std::sin (0.01 * i)));
+
+                engine.process (buffer.getArrayOfWritePointers(), layout.size(), numSamples, params);
+
+                auto centreMatches = [&] (const juce::AudioBuffer<float>& other, int otherChannel)
+                {
+                    return std::equal (buffer.getReadPointer (centre), buffer.getReadPointer (centre) + numSamples,
+                                       other.getReadPointer (otherChannel));
+                };
+
+                if (spread == 0.0f)
+                    unspread.makeCopyOf (buffer);
+
+                const auto matches = centreMatches (buffer, lfe) && centreMatches (unspread, centre);
+                std::printf ("5.1, %d voices, spread %.1f: centre and LFE %s\n", voices, static_cast<double> (spread),
+                             matches ? "match" : "DIFFER");
+                allMatch = allMatch && matches;
+            }
+        }
+
+        return allMatch;
+    }
+
+    //==============================================================================
+    juce::Array<Case> createCases (bool full)
+    {
+        juce::Array<Case> cases;
+        const int blockSizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+        const int channelCounts[] = { 1, 2, 4, 6, 8, 12, 16 };
+        const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+
+        auto forEachStages = [] (auto&& fn)
+        {
+            for (auto chorus : { false, true })
+                for (int mode = -1; mode < SaturationKernels::numModes; ++mode)
+                    for (int clipper = 0; clipper < 3; ++clipper)
+                        fn (chorus, mode, clipper);
+        };
+
+        if (full)
+        {
+            for (auto blockSize : blockSizes)
+                for (auto numChannels : channelCounts)
+                    for (auto sampleRate : sampleRates)
+                        forEachStages ([&] (bool chorus, int mode, int clipper)
+                        {
+                            Case c;
+                            c.group = "full";
+                            c.chorus = chorus;
+                            c.saturationMode = mode;
+                            c.clipper = clipper;
+                            c.blockSize = blockSize;
+                            c.numChannels = numChannels;
+                            c.sampleRate = sampleRate;
+                            cases.add (c);
+                        });
+        }
+        else
+        {
+            forEachStages ([&] (bool chorus, int mode, int clipper)
+            {
+                Case c;
+                c.group = "stages";
+                c.chorus = chorus;
+                c.saturationMode = mode;
+                c.clipper = clipper;
+                cases.add (c);
+            });
+
+            for (auto blockSize : blockSizes)
+            {
+                Case c;
+                c.group = "block size";
+                c.blockSize = blockSize;
+                cases.add (c);
+            }
+
+            for (auto numChannels : channelCounts)
+            {
+                Case c;
+                c.group = "channels";
+                c.numChannels = numChannels;
+                cases.add (c);
+            }
+
+            for (auto sampleRate : sampleRates)
+            {
+                Case c;
+                c.group = "sample rate";
+                c.sampleRate = sampleRate;
+                cases.add (c);
+            }
+
+            // The ensemble against the two voice chorus, on its own and through the whole chain
+            for (auto chorusVoices : { 1, 2, 4, 8 })
+            {
+                for (auto stages : { false, true })
+                {
+                    Case c;
+                    c.group = "voices";
+                    c.chorusVoices = chorusVoices;
+                    c.saturationMode = stages ? 0 : -1;
+                    c.clipper = stages ? 2 : 0;
+                    cases.add (c);
+                }
+            }
+        }
+
+        // Automation, the editor and the engine on its own, each against the same
+        // processBlock case without, at a typical and a small block size
+        for (auto blockSize : { 64, 512 })
+        {
+            for (auto engineOnly : { false, true })
+            {
+                Case c;
+                c.group = "engine";
+                c.blockSize = blockSize;
+                c.engineOnly = engineOnly;
+                cases.add (c);
+            }
+
+            for (auto automation : { false, true })
+            {
+                Case c;
+                c.group = "automation";
+                c.blockSize = blockSize;
+                c.automation = automation;
+                cases.add (c);
+            }
+
+            for (auto editor : { false, true })
+            {
+                Case c;
+                c.group = "editor";
+                c.blockSize = blockSize;
+                c.editor = editor;
+                cases.add (c);
+            }
+
+            // Idle instances: a silent track, and one the host has bypassed, against
+            // the same instance playing
+            for (auto idle : { 0, 1, 2 })
+            {
+                Case c;
+                c.group = "idle";
+                c.blockSize = blockSize;
+                c.silentInput = idle == 1;
+                c.bypassed = idle == 2;
+                cases.add (c);
+            }
+
+            // The profiler timing whole blocks only, then every stage as well
+            for (auto stageTiming : { false, true })
+            {
+                Case c;
+                c.group = "profiler";
+                c.blockSize = blockSize;
+                c.stageTiming = stageTiming;
+                cases.add (c);
+            }
+
+            // A 12 channel bed: one instance, then six stereo ones
+            for (auto numInstances : { 1, 6 })
+            {
+                Case c;
+                c.group = "bed";
+                c.blockSize = blockSize;
+                c.numChannels = 12;
+                c.numInstances = numInstances;
+                cases.add (c);
+            }
+        }
+
+        return cases;
+    }
+
+    void printResult (const Result& result)
+    {
+        const auto& c = result.benchmark;
+
+        std::printf ("%-12s %-36s %6d %3d %4d %7.0f %-4s %-4s %-4s %-4s %-4s %-4s %10.3f %10.5f\n", c.group, c.getStages().toRawUTF8(),
+                     c.blockSize, c.numChannels, c.numInstances, c.sampleRate, c.automation ? "yes" : "no", c.editor ? "yes" : "no",
+                     c.engineOnly ? "yes" : "no", c.silentInput ? "yes" : "no", c.bypassed ? "yes" : "no", c.stageTiming ? "yes" : "no",
+                     result.nsPerSample, result.getRealTimeFactor());
+    }
+
+    Result runCase (const Case& benchmark)
+    {
+        Result result { benchmark };
+
+        if (benchmark.engineOnly)
+        {
+            result.nsPerSample = timeEngine (benchmark);
+        }
+        else
+        {
+            juce::OwnedArray<ClipSatAudioProcessor> processors;
+
+            for (int instance = 0; instance < benchmark.numInstances; ++instance)
+                if (auto processor = createProcessor (benchmark))
+                    processors.add (processor.release());
+
+            if (processors.size() == benchmark.numInstances)
+                result.nsPerSample = timeCase (juce::Array<ClipSatAudioProcessor*> (processors.begin(), processors.size()), benchmark);
+        }
+
+        printResult (result);
+        return result;
+    }
+
+    /** The editor's visualiser drains its FIFOs on a message thread timer. So the
+        FIFOs don't just fill up and start dropping, these cases process on another
+        thread, like a host's audio thread, while this one dispatches messages.
+        The cases without an editor run the same way, to compare like with like.
+    */
+    void runEditorCases (const juce::Array<Case>& editorCases, juce::Array<Result>& results)
+    {
+        struct Instance
+        {
+            Case benchmark;
+            std::unique_ptr<ClipSatAudioProcessor> processor;
+            std::unique_ptr<juce::AudioProcessorEditor> editor;
+        };
+
+        std::vector<Instance> instances;
+
+        for (auto& benchmark : editorCases)
+        {
+            Instance instance { benchmark, createProcessor (benchmark), nullptr };
+
+            if (instance.processor != nullptr && benchmark.editor)
+                instance.editor.reset (instance.processor->createEditorIfNeeded());
+
+            instances.push_back (std::move (instance));
+        }
+
+        juce::Thread::launch ([&]
+        {
+            for (auto& instance : instances)
+            {
+                Result result { instance.benchmark };
+
+                if (instance.processor != nullptr)
+                    result.nsPerSample = timeCase ({ instance.processor.get() }, instance.benchmark);
+
+                printResult (result);
+                results.add (result);
+            }
+
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        });
+
+        juce::MessageManager::getInstance()->runDispatchLoop();
+
+        // Editors go before their processors
+        for (auto& instance : instances)
+            instance.editor.reset();
+    }
+
+    void writeJson (const juce::File& file, const juce::String& label, const juce::Array<Result>& results)
+    {
+        juce::Array<juce::var> entries;
+
+        for (auto& result : results)
+        {
+            const auto& c = result.benchmark;
+            auto* entry = new juce::DynamicObject();
+
+            entry->setProperty ("group", c.group);
+            entry->setProperty ("chorus", c.chorus);
+            entry->setProperty ("chorusVoices", c.chorusVoices);
+            entry->setProperty ("saturationMode", c.saturationMode >= 0 ? juce::var (saturationModeNames[c.saturationMode]) : juce::var());
+            entry->setProperty ("clipper", clipperNames[c.clipper]);
+            entry->setProperty ("blockSize", c.blockSize);
+            entry->setProperty ("numChannels", c.numChannels);
+            entry->setProperty ("numInstances", c.numInstances);
+            entry->setProperty ("sampleRate", c.sampleRate);
+            entry->setProperty ("automation", c.automation);
+            entry->setProperty ("editor", c.editor);
+            entry->setProperty ("engineOnly", c.engineOnly);
+            entry->setProperty ("silentInput", c.silentInput);
+            entry->setProperty ("bypassed", c.bypassed);
+            entry->setProperty ("stageTiming", c.stageTiming);
+            entry->setProperty ("nsPerSample", result.nsPerSample);
+            entry->setProperty ("realTimeFactor", result.getRealTimeFactor());
+
+            entries.add (juce::var (entry));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("label", label);
+        root->setProperty ("time", juce::Time::getCurrentTime().toISO8601 (true));
+        root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        root->setProperty ("juceVersion", juce::SystemStats::getJUCEVersion());
+        root->setProperty ("results", entries);
+
+        if (file.replaceWithText (juce::JSON::toString (juce::var (root))))
+            std::printf ("\nWrote %s\n", file.getFullPathName().toRawUTF8());
+        else
+            std::printf ("\nCan't write %s\n", file.getFullPathName().toRawUTF8());
+    }
+
+    juce::String getOptionValue (const juce::StringArray& args, const char* option)
+    {
+        const auto index = args.indexOf (option);
+        return index >= 0 ? args[index + 1] : juce::String();
+    }
+}
+
+//==============================================================================
+int runChainBenchmarks (const juce::StringArray& args)
+{
+    std::printf ("\nChain: chorus spread in surround\n");
+
+    if (! checkSurroundSpread())
+    {
+        std::printf ("The chorus spread pans a channel that isn't in a stereo pair\n");
+        return 1;
+    }
+
+    const auto cases = createCases (args.contains ("--full"));
+
+    std::printf ("\nChain: processBlock at the default accuracy tier and 1x oversampling, best of %d runs\n", numRuns);
+    std::printf ("%-12s %-36s %6s %3s %4s %7s %-4s %-4s %-4s %-4s %-4s %-4s %10s %10s\n", "group", "stages", "block", "ch", "inst", "rate",
+                 "auto", "ed", "eng", "sil", "byp", "stg", "ns/sample", "rt factor");
+
+    juce::Array<Result> results;
+    juce::Array<Case> editorCases;
+
+    for (auto& benchmark : cases)
+    {
+        if (juce::String (benchmark.group) == "editor")
+            editorCases.add (benchmark);
+        else
+            results.add (runCase (benchmark));
+    }
+
+    if (! editorCases.isEmpty())
+        runEditorCases (editorCases, results);
+
+    const auto jsonFile = getOptionValue (args, "--json");
+
+    if (jsonFile.isNotEmpty())
+        writeJson (juce::File::getCurrentWorkingDirectory().getChildFile (jsonFile), getOptionValue (args, "--label"), results);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    DispatchBenchmarks.cpp
+
+    ns/sample for each build of the span kernels (see SpanKernels.h) that
+    this CPU can run, side by side, in float and double. Every build is
+    checked against the baseline for the same input: the suite fails if any
+    output differs by more than the sign of a zero.
+
+    Run with --cpu <variant> (see Main.cpp) to force the variant the rest of
+    the suites process with.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/CpuDispatch.h"
+#include "../../Source/FastMath.h"
+#include <vector>
+
+namespace
+{
+    using FastMath::Accuracy;
+
+    constexpr int numSamples = 1 << 12;
+
+    template <typename SampleType>
+    struct Kernel
+    {
+        const char* name;
+        void (*run) (const SpanKernels::Table<SampleType>&, SampleType* data, SampleType* scratch, const SampleType* ramp, int numSamples);
+    };
+
+    template <typename SampleType>
+    std::vector<Kernel<SampleType>> getKernels()
+    {
+        using Table = SpanKernels::Table<SampleType>;
+        constexpr SampleType drive = 4, threshold = SampleType (0.5);
+
+        return {
+            { "Soft Sine",          [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.saturate (0, Accuracy::accurate, d, n, drive); } },
+            { "Soft Sine, fast",    [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.saturate (0, Accuracy::fast, d, n, drive); } },
+            { "Soft Sine, ramp",    [] (const Table& k, SampleType* d, SampleType*, const SampleType* r, int n) { k.saturateRamp (0, Accuracy::accurate, d, n, r); } },
+            { "Hard Curve",         [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.saturate (1, Accuracy::accurate, d, n, drive); } },
+            { "Analog Clip",        [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.saturate (2, Accuracy::accurate, d, n, drive); } },
+            { "Sinoid Fold",        [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.saturate (3, Accuracy::accurate, d, n, drive); } },
+            { "Soft clip",          [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.softClip (Accuracy::accurate, d, n, threshold); } },
+            { "Soft clip, fast",    [] (const Table& k, SampleType* d, SampleType*, const SampleType*, int n) { k.softClip (Accuracy::fast, d, n, threshold); } },
+            { "Soft clip, ramp",    [] (const Table& k, SampleType* d, SampleType*, const SampleType* r, int n) { k.softClipRamp (Accuracy::accurate, d, n, r); } },
+            { "Hard clip, ramp",    [] (const Table& k, SampleType* d, SampleType*, const SampleType* r, int n) { k.hardClipRamp (d, n, r); } },
+            { "Dry/wet mix",        [] (const Table& k, SampleType* d, SampleType* s, const SampleType*, int n) { k.mixDryWet (d, s, n, nullptr, SampleType (0.3)); } },
+            { "Dry/wet mix, ramp",  [] (const Table& k, SampleType* d, SampleType* s, const SampleType* r, int n) { k.mixDryWet (d, s, n, r, 0); } }
+        };
+    }
+
+    /** Runs kernel over a sweep of -2 to 2 with a ramp from 0.1 to 1, into output. */
+    template <typename SampleType>
+    struct Run
+    {
+        Run()
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto position = static_cast<SampleType> (i) / static_cast<SampleType> (numSamples - 1);
+                input[i] = 4 * position - 2;
+                ramp[i] = SampleType (0.1) + SampleType (0.9) * position;
+            }
+        }
+
+        void operator() (const Kernel<SampleType>& kernel, const SpanKernels::Table<SampleType>& table)
+        {
+            // The dry/wet kernels read the reversed sweep as their wet signal
+            for (int i = 0; i < numSamples; ++i)
+                scratch[i] = input[numSamples - 1 - i];
+
+            juce::FloatVectorOperations::copy (output.get(), input.get(), numSamples);
+            kernel.run (table, output, scratch, ramp, numSamples);
+        }
+
+        juce::HeapBlock<SampleType> input { numSamples }, ramp { numSamples }, output { numSamples }, scratch { numSamples };
+    };
+
+    template <typename SampleType>
+    bool runKernels (const char* typeName, const std::vector<CpuDispatch::Variant>& variants)
+    {
+        Run<SampleType> run;
+        std::vector<SampleType> baseline (numSamples);
+        bool allMatch = true;
+
+        for (auto& kernel : getKernels<SampleType>())
+        {
+            std::printf ("%-20s %-7s", kernel.name, typeName);
+            bool matches = true;
+
+            for (auto variant : variants)
+            {
+                const auto& table = CpuDispatch::getBuild (variant)->template get<SampleType>();
+
+                const auto ns = Benchmark::nanosecondsPerSample ([&]
+                {
+                    run (kernel, table);
+                    Benchmark::sink = Benchmark::sink + static_cast<float> (run.output[numSamples / 2]);
+                }, numSamples);
+
+                std::printf (" %10.3f", ns);
+
+                if (variant == variants.front())
+                    std::copy (run.output.get(), run.output.get() + numSamples, baseline.begin());
+                else
+                    matches = matches && std::equal (baseline.begin(), baseline.end(), run.output.get()); // +0 == -0
+            }
+
+            std::printf (" %9s\n", matches ? "yes" : "NO");
+            allMatch = allMatch && matches;
+        }
+
+        return allMatch;
+    }
+}
+
+//==============================================================================
+int runDispatchBenchmarks (const juce::StringArray&)
+{
+    std::vector<CpuDispatch::Variant> variants;
+
+    for (int variant = 0; variant < CpuDispatch::numVariants; ++variant)
+        if (CpuDispatch::isSupported (static_cast<CpuDispatch::Variant> (variant)))
+            variants.push_back (static_cast<CpuDispatch::Variant> (variant));
+
+    std::printf ("\nDispatch: span kernels per instruction set, %d samples per run, best of 25 runs\n", numSamples);
+    std::printf ("Active: %s, best for this CPU: %s\n", CpuDispatch::getVariantName (CpuDispatch::getActiveVariant()),
+                 CpuDispatch::getVariantName (CpuDispatch::getBestVariant()));
+
+    std::printf ("%-20s %-7s", "kernel", "type");
+
+    for (auto variant : variants)
+        std::printf (" %7s ns", CpuDispatch::getVariantName (variant));
+
+    std::printf (" %9s\n", "matches");
+
+    const bool floatsMatch = runKernels<float> ("float", variants);
+    const bool doublesMatch = runKernels<double> ("double", variants);
+
+    if (! (floatsMatch && doublesMatch))
+    {
+        std::printf ("A build's output differs from the baseline's\n");
+        return 1;
+    }
+
+    return 0;
+}
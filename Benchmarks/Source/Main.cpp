@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Entry point for the benchmark suites. Run with a suite name to run just
+    that suite, or with no arguments to run all of them:
+
+        ClipSatBenchmarks [math | processing | chain | aliasing | state | undo | memory | dispatch |
+                           scheduler]
+                          [--cpu sse2 | avx2 | avx512] [options]
+
+    --cpu forces the instruction set the span kernels run on (see
+    CpuDispatch.h) for every suite. Any other options are passed on to the
+    suite (see ChainBenchmarks.cpp, UndoBenchmarks.cpp and
+    MemoryBenchmarks.cpp).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BenchmarkHarness.h"
+#include "../../Source/CpuDispatch.h"
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor suites need a message manager for their parameters
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    const auto cpuIndex = args.indexOf ("--cpu");
+
+    if (cpuIndex >= 0 && ! CpuDispatch::force (args[cpuIndex + 1]))
+    {
+        std::printf ("This CPU can't run '%s'\n", args[cpuIndex + 1].toRawUTF8());
+        return 1;
+    }
+
+    struct Suite
+    {
+        const char* name;
+        int (*run) (const juce::StringArray&);
+    };
+
+    const Suite suites[] =
+    {
+        { "math",       runMathBenchmarks },
+        { "processing", runProcessingBenchmarks },
+        { "chain",      runChainBenchmarks },
+        { "aliasing",   runAliasingBenchmarks },
+        { "state",      runStateBenchmarks },
+        { "undo",       runUndoBenchmarks },
+        { "memory",     runMemoryBenchmarks },
+        { "dispatch",   runDispatchBenchmarks },
+        { "scheduler",  runSchedulerBenchmarks }
+    };
+
+    const auto suiteName = args.isEmpty() || args[0].startsWith ("--") ? juce::String() : args[0];
+    int result = 0;
+    bool found = false;
+
+    for (auto& suite : suites)
+    {
+        if (suiteName.isEmpty() || suiteName == suite.name)
+        {
+            found = true;
+            result |= suite.run (args);
+        }
+    }
+
+    if (! found)
+    {
+        std::printf ("Unknown suite '%s'\n", suiteName.toRawUTF8());
+        return 1;
+    }
+
+    return result;
+}
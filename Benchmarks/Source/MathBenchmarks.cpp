@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    MathBenchmarks.cpp
+
+    ns/sample and maximum error against libm for the FastMath approximations
+    and the saturation/clipper kernels built on them, in every accuracy tier.
+    Lookup tables (juce::dsp::LookupTableTransform) are included as a point of
+    comparison for the polynomials.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/FastMath.h"
+#include "../../Source/SaturationKernels.h"
+
+namespace
+{
+    using FastMath::Accuracy;
+
+    constexpr int numSamples = 1 << 14;
+
+    const char* getTierName (Accuracy accuracy)
+    {
+        switch (accuracy)
+        {
+            case Accuracy::exact:    return "exact";
+            case Accuracy::accurate: return "accurate";
+            case Accuracy::fast:     return "fast";
+            default:                 return "";
+        }
+    }
+
+    void printRow (const char* name, const char* tier, double nsPerSample, double maxError)
+    {
+        std::printf ("%-24s %-10s %10.3f %14.3e\n", name, tier, nsPerSample, maxError);
+    }
+
+    /** Times fn (input, output) over a sweep of the input range, and measures the
+        largest absolute error of its output against reference.
+    */
+    template <typename Fn, typename Reference>
+    void runFunction (const char* name, const char* tier, float range, Fn&& fn, Reference&& reference)
+    {
+        juce::HeapBlock<float> input (numSamples), output (numSamples);
+        Benchmark::fillRamp (input, numSamples, range);
+
+        auto ns = Benchmark::nanosecondsPerSample ([&]
+        {
+            fn (input.get(), output.get(), numSamples);
+            Benchmark::sink = Benchmark::sink + output[numSamples / 2];
+        }, numSamples);
+
+        double maxError = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+            maxError = juce::jmax (maxError, std::abs (static_cast<double> (output[i]) - reference (static_cast<double> (input[i]))));
+
+        printRow (name, tier, ns, maxError);
+    }
+
+    template <Accuracy accuracy>
+    void runFastMathFunctions()
+    {
+        const auto* tier = getTierName (accuracy);
+
+        runFunction ("sin", tier, 40.0f,
+                     [] (const float* in, float* out, int n) { for (int i = 0; i < n; ++i) out[i] = FastMath::sin<accuracy> (in[i]); },
+                     [] (double x) { return std::sin (x); });
+
+        // Relative error, so the large end of the range doesn't dominate
+        runFunction ("exp (relative)", tier, 20.0f,
+                     [] (const float* in, float* out, int n) { for (int i = 0; i < n; ++i) out[i] = FastMath::exp<accuracy> (in[i]) / std::exp (in[i]); },
+                     [] (double) { return 1.0; });
+    }
+
+    template <typename Kernel, typename Reference>
+    void runKernel (const char* name, Accuracy accuracy, float range, Kernel&& kernel, Reference&& reference)
+    {
+        runFunction (name, getTierName (accuracy), range,
+                     [&] (const float* in, float* out, int n)
+                     {
+                         juce::FloatVectorOperations::copy (out, in, n);
+                         kernel (accuracy, out, n);
+                     },
+                     reference);
+    }
+}
+
+//==============================================================================
+int runMathBenchmarks (const juce::StringArray&)
+{
+    std::printf ("\nMath: %d samples per run, best of 25 runs\n", numSamples);
+    std::printf ("%-24s %-10s %10s %14s\n", "function", "tier", "ns/sample", "max error");
+
+    runFunction ("sin", "libm", 40.0f,
+                 [] (const float* in, float* out, int n) { for (int i = 0; i < n; ++i) out[i] = std::sin (in[i]); },
+                 [] (double x) { return std::sin (x); });
+
+    runFastMathFunctions<Accuracy::accurate>();
+    runFastMathFunctions<Accuracy::fast>();
+
+    {
+        constexpr auto halfPi = juce::MathConstants<float>::halfPi;
+        juce::dsp::LookupTableTransform<float> sineTable ([] (float x) { return std::sin (x); }, -halfPi, halfPi, 512);
+
+        runFunction ("sin (512 point table)", "table", 40.0f,
+                     [&] (const float* in, float* out, int n) { for (int i = 0; i < n; ++i) out[i] = sineTable.processSample (FastMath::fold (in[i])); },
+                     [] (double x) { return std::sin (x); });
+
+        juce::dsp::LookupTableTransform<float> expTable ([] (float x) { return std::exp (x); }, -20.0f, 0.0f, 1024);
+
+        runFunction ("exp (1024 point table)", "table", 20.0f,
+                     [&] (const float* in, float* out, int n) { for (int i = 0; i < n; ++i) out[i] = expTable.processSample (-std::abs (in[i])); },
+                     [] (double x) { return std::exp (-std::abs (x)); });
+    }
+
+    std::printf ("\nKernels (drive 4, threshold 0.5), error against the original libm curves\n");
+    std::printf ("%-24s %-10s %10s %14s\n", "kernel", "tier", "ns/sample", "max error");
+
+    const char* modeNames[] = { "Soft Sine", "Hard Curve", "Analog Clip", "Sinoid Fold" };
+    constexpr float drive = 4.0f;
+    constexpr float threshold = 0.5f;
+
+    for (int mode = 0; mode < SaturationKernels::numModes; ++mode)
+        for (auto accuracy : { Accuracy::exact, Accuracy::accurate, Accuracy::fast })
+            runKernel (modeNames[mode], accuracy, 2.0f,
+                       [mode] (Accuracy a, float* data, int n) { SaturationKernels::processBlock (mode, a, data, n, drive); },
+                       [mode] (double x) { return static_cast<double> (SaturationKernels::reference (mode, static_cast<float> (x), drive)); });
+
+    for (auto accuracy : { Accuracy::exact, Accuracy::accurate, Accuracy::fast })
+        runKernel ("Soft Clip", accuracy, 2.0f,
+                   [] (Accuracy a, float* data, int n) { SaturationKernels::softClipBlock (a, data, n, threshold); },
+                   [] (double x) { return static_cast<double> (SaturationKernels::softClipReference (static_cast<float> (x), threshold)); });
+
+    return 0;
+}
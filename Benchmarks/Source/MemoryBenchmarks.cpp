@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    MemoryBenchmarks.cpp
+
+    What an instance costs in memory, for budgeting sessions with hundreds
+    of them: ClipSatAudioProcessor::getMemoryFootprint() after prepareToPlay
+    at each common sample rate, for stereo and for the widest layout, with
+    512 sample blocks. The first configuration is broken down subsystem by
+    subsystem, and every one is totalled, with the cost of 100 instances.
+
+    Then a session's worth of instances (200, or --instances) is created
+    and prepared at 48 kHz stereo, the way a host loads them, timing
+    construction and prepareToPlay separately. Nothing an instance builds
+    is the same from one instance to the next, so this is the cost to beat
+    before sharing anything between them.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr int blockSize = 512;
+
+    bool setChannels (ClipSatAudioProcessor& processor, int numChannels)
+    {
+        const auto channels = juce::AudioChannelSet::discreteChannels (numChannels);
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channels);
+        layout.outputBuses.add (channels);
+
+        return processor.setBusesLayout (layout);
+    }
+
+    MemoryFootprint prepareAndMeasure (double sampleRate, int numChannels)
+    {
+        ClipSatAudioProcessor processor;
+
+        if (! setChannels (processor, numChannels))
+            return {};
+
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+        return processor.getMemoryFootprint();
+    }
+
+    double secondsSince (juce::int64 startTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    void loadSession (int numInstances)
+    {
+        constexpr double sampleRate = 48000.0;
+        juce::OwnedArray<ClipSatAudioProcessor> instances;
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numInstances; ++i)
+            setChannels (*instances.add (new ClipSatAudioProcessor()), 2);
+
+        const auto constructSeconds = secondsSince (start);
+        start = juce::Time::getHighResolutionTicks();
+
+        for (auto* instance : instances)
+        {
+            instance->setRateAndBufferSizeDetails (sampleRate, blockSize);
+            instance->prepareToPlay (sampleRate, blockSize);
+        }
+
+        const auto prepareSeconds = secondsSince (start);
+        size_t totalBytes = 0;
+
+        for (auto* instance : instances)
+            totalBytes += instance->getMemoryFootprint().getTotalBytes();
+
+        start = juce::Time::getHighResolutionTicks();
+        instances.clear();
+        const auto destroySeconds = secondsSince (start);
+
+        std::printf ("\n%d instances, 48 kHz, 2 channels\n", numInstances);
+        std::printf ("%-14s %10s %14s\n", "", "total ms", "per instance");
+        std::printf ("%-14s %10.1f %11.3f ms\n", "construct", constructSeconds * 1000.0, constructSeconds * 1000.0 / numInstances);
+        std::printf ("%-14s %10.1f %11.3f ms\n", "prepareToPlay", prepareSeconds * 1000.0, prepareSeconds * 1000.0 / numInstances);
+        std::printf ("%-14s %10.1f %11.3f ms\n", "destroy", destroySeconds * 1000.0, destroySeconds * 1000.0 / numInstances);
+        std::printf ("Footprint: %.1f MB in all\n", static_cast<double> (totalBytes) / (1024.0 * 1024.0));
+    }
+}
+
+//==============================================================================
+int runMemoryBenchmarks (const juce::StringArray& args)
+{
+    std::printf ("\nMemory: footprint per instance after prepareToPlay, %d samples per block\n", blockSize);
+
+    const auto detail = prepareAndMeasure (192000.0, 2);
+    std::printf ("\n192 kHz, 2 channels\n%s", detail.toString().toRawUTF8());
+
+    std::printf ("\n%10s %8s %12s %12s %14s\n", "rate", "channels", "arena KB", "total KB", "100 inst. MB");
+
+    for (auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+    {
+        for (auto numChannels : { 2, ClipSatEngine<float>::maxNumChannels })
+        {
+            const auto footprint = prepareAndMeasure (sampleRate, numChannels);
+            const auto total = static_cast<double> (footprint.getTotalBytes());
+
+            std::printf ("%10.0f %8d %12.1f %12.1f %14.1f\n", sampleRate, numChannels, static_cast<double> (footprint.getArenaBytes()) / 1024.0,
+                         total / 1024.0, 100.0 * total / (1024.0 * 1024.0));
+        }
+    }
+
+    const auto instancesIndex = args.indexOf ("--instances");
+    loadSession (instancesIndex >= 0 ? juce::jmax (1, args[instancesIndex + 1].getIntValue()) : 200);
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    ProcessingBenchmarks.cpp
+
+    ns/sample for ClipSatAudioProcessor::processBlock in common stage
+    configurations, running the generic stage-by-stage path against the fused
+    per-configuration kernels. Each configuration also reports the largest
+    difference between the two paths' outputs for the same input.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 64;
+    constexpr int numChannels = 2;
+
+    struct Configuration
+    {
+        const char* name;
+        bool chorus, saturator, clipper, softClipping;
+        int saturationMode;
+    };
+
+    void setParameter (ClipSatAudioProcessor& processor, const char* parameterID, float value)
+    {
+        auto* parameter = processor.parameters.getParameter (parameterID);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    std::unique_ptr<ClipSatAudioProcessor> createProcessor (const Configuration& configuration, int accuracy, bool fused)
+    {
+        auto processor = std::make_unique<ClipSatAudioProcessor>();
+
+        setParameter (*processor, "chorusOnOff", configuration.chorus ? 1.0f : 0.0f);
+        setParameter (*processor, "satOnOff", configuration.saturator ? 1.0f : 0.0f);
+        setParameter (*processor, "clipperOnOff", configuration.clipper ? 1.0f : 0.0f);
+        setParameter (*processor, "softClipping", configuration.softClipping ? 1.0f : 0.0f);
+        setParameter (*processor, "saturationMode", static_cast<float> (configuration.saturationMode));
+        setParameter (*processor, "accuracy", static_cast<float> (accuracy));
+        setParameter (*processor, "drive", 4.0f);
+
+        processor->setFusedProcessingEnabled (fused);
+        processor->prepareToPlay (sampleRate, blockSize);
+        return processor;
+    }
+
+    /** numBlocks of a two channel test signal: a swept sine, loud enough to reach the clipper. */
+    juce::AudioBuffer<float> createInput()
+    {
+        juce::AudioBuffer<float> input (numChannels, blockSize * numBlocks);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = input.getWritePointer (channel);
+            double phase = 0.0;
+
+            for (int i = 0; i < input.getNumSamples(); ++i)
+            {
+                data[i] = 0.9f * static_cast<float> (std::sin (phase));
+                phase += juce::MathConstants<double>::twoPi * (100.0 + 40.0 * i / blockSize + 30.0 * channel) / sampleRate;
+            }
+        }
+
+        return input;
+    }
+
+    /** Processes all of input, block by block, into output. */
+    void render (ClipSatAudioProcessor& processor, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        juce::AudioBuffer<float> block (numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < input.getNumSamples(); start += blockSize)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                block.copyFrom (channel, 0, input, channel, start, blockSize);
+
+            processor.processBlock (block, midi);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                output.copyFrom (channel, start, block, channel, 0, blockSize);
+        }
+    }
+
+    double timeRender (ClipSatAudioProcessor& processor, const juce::AudioBuffer<float>& input)
+    {
+        juce::AudioBuffer<float> output (numChannels, input.getNumSamples());
+
+        return Benchmark::nanosecondsPerSample ([&]
+        {
+            render (processor, input, output);
+            Benchmark::sink = Benchmark::sink + output.getSample (0, output.getNumSamples() / 2);
+        }, input.getNumSamples());
+    }
+
+    float maximumDifference (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        float difference = 0.0f;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                difference = juce::jmax (difference, std::abs (a.getSample (channel, i) - b.getSample (channel, i)));
+
+        return difference;
+    }
+}
+
+//==============================================================================
+int runProcessingBenchmarks (const juce::StringArray&)
+{
+    const Configuration configurations[] =
+    {
+        { "Chorus, Soft Sine, hard",  true,  true,  true,  false, 0 },
+        { "Chorus, Soft Sine, soft",  true,  true,  true,  true,  0 },
+        { "Soft Sine, hard",          false, true,  true,  false, 0 },
+        { "Hard Curve, soft",         false, true,  true,  true,  1 },
+        { "Analog Clip, hard",        false, true,  true,  false, 2 },
+        { "Sinoid Fold, soft",        false, true,  true,  true,  3 },
+        { "Chorus only",              true,  false, false, false, 0 },
+        { "Hard clipper only",        false, false, true,  false, 0 },
+        { "Soft clipper only",        false, false, true,  true,  0 }
+    };
+
+    const char* tierNames[] = { "exact", "accurate", "fast" };
+    const auto input = createInput();
+
+    std::printf ("\nProcessing: %d channels, %d sample blocks at %.0f Hz, 1x oversampling, best of 25 runs\n",
+                 numChannels, blockSize, sampleRate);
+    std::printf ("%-26s %-10s %12s %12s %9s %12s\n", "configuration", "tier", "generic ns", "fused ns", "speedup", "max diff");
+
+    for (auto& configuration : configurations)
+    {
+        for (int accuracy = 1; accuracy <= 2; ++accuracy)
+        {
+            auto generic = createProcessor (configuration, accuracy, false);
+            auto fused = createProcessor (configuration, accuracy, true);
+
+            // Both paths from the same fresh state, before timing moves them on
+            juce::AudioBuffer<float> genericOutput (numChannels, input.getNumSamples()), fusedOutput (numChannels, input.getNumSamples());
+            render (*generic, input, genericOutput);
+            render (*fused, input, fusedOutput);
+            const auto difference = maximumDifference (genericOutput, fusedOutput);
+
+            const auto genericNs = timeRender (*generic, input);
+            const auto fusedNs = timeRender (*fused, input);
+
+            std::printf ("%-26s %-10s %12.3f %12.3f %8.2fx %12.3e\n", configuration.name, tierNames[accuracy],
+                         genericNs, fusedNs, genericNs / fusedNs, static_cast<double> (difference));
+        }
+    }
+
+    return 0;
+}
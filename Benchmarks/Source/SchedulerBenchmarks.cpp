@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    SchedulerBenchmarks.cpp
+
+    ns/sample for ClipSatEngine across host block sizes from 1 to 8192, at
+    1x, 2x and 4x oversampling. The engine runs the chain a sub-block at a
+    time (see ClipSatEngine::subBlockSize), so from the sub-block size up
+    the cost per sample should stay flat, and the output shouldn't depend on
+    the host's block size at all: every size that is a whole number of
+    sub-blocks is checked against the largest, and the suite fails if any
+    output differs. Smaller blocks run straight through, one per call, so
+    they pay the chain's fixed cost per block and their output can differ
+    by the smoothing steps.
+
+    Every engine has a StageProfiler attached, as the plugin's do. "ns" is
+    with its stage timing off, as the plugin runs by default; "staged ns"
+    is with it on, which reads the clock at every stage of every sub-block.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/ClipSatEngine.h"
+
+namespace
+{
+    using Engine = ClipSatEngine<float>;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int numSamples = 1 << 14;
+    constexpr int numChannels = 2;
+    constexpr int numRuns = 9;
+
+    struct Configuration
+    {
+        const char* name;
+        bool chorus;
+        int oversamplingStages;
+    };
+
+    Engine::Params createParams (const Configuration& configuration)
+    {
+        Engine::Params params;
+        params.drive = 4.0f;
+        params.dryWet = 0.5f;
+        params.depth = 0.1f;
+        params.mix = 0.5f;
+        params.setThresholdDecibels (-6.0f);
+        params.chorusOn = configuration.chorus;
+        params.satOn = true;
+        params.clipperOn = true;
+        params.softClipping = true;
+        params.oversamplingStages = configuration.oversamplingStages;
+        return params;
+    }
+
+    /** A swept sine on both channels, loud enough to reach the clipper. */
+    juce::AudioBuffer<float> createInput()
+    {
+        juce::AudioBuffer<float> input (numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = input.getWritePointer (channel);
+            double phase = 0.0;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                data[i] = 0.9f * static_cast<float> (std::sin (phase));
+                phase += juce::MathConstants<double>::twoPi * (100.0 + 4000.0 * i / numSamples + 30.0 * channel) / sampleRate;
+            }
+        }
+
+        return input;
+    }
+
+    /** Processes the whole of buffer in place, blockSize samples per call. The
+        drive moves halfway through, so the smoothers are ramping for part of it.
+    */
+    void render (Engine& engine, juce::AudioBuffer<float>& buffer, int blockSize, const Engine::Params& initialParams)
+    {
+        auto params = initialParams;
+        float* channels[numChannels];
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            if (start >= numSamples / 2)
+                params.drive = 6.0f;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                channels[channel] = buffer.getWritePointer (channel, start);
+
+            engine.process (channels, numChannels, juce::jmin (blockSize, numSamples - start), params);
+        }
+    }
+
+    /** The output of a freshly prepared engine for input, processed blockSize samples at a time. */
+    juce::AudioBuffer<float> renderFresh (const Configuration& configuration, const juce::AudioBuffer<float>& input, int blockSize)
+    {
+        const auto params = createParams (configuration);
+        Engine engine;
+        engine.prepare (sampleRate, blockSize, numChannels, params);
+
+        juce::AudioBuffer<float> output (input);
+        render (engine, output, blockSize, params);
+        return output;
+    }
+
+    double timeBlockSize (const Configuration& configuration, const juce::AudioBuffer<float>& input, int blockSize, bool stageTiming)
+    {
+        const auto params = createParams (configuration);
+        StageProfiler profiler;
+        profiler.setStageTimingEnabled (stageTiming);
+
+        Engine engine;
+        engine.setProfiler (&profiler);
+        engine.prepare (sampleRate, blockSize, numChannels, params);
+
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+
+        return Benchmark::nanosecondsPerSample ([&]
+        {
+            buffer.makeCopyOf (input, true);
+            render (engine, buffer, blockSize, params);
+            Benchmark::sink = Benchmark::sink + buffer.getSample (0, numSamples / 2);
+        }, numSamples, numRuns);
+    }
+
+    bool isIdentical (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (! std::equal (a.getReadPointer (channel), a.getReadPointer (channel) + numSamples, b.getReadPointer (channel)))
+                return false;
+
+        return true;
+    }
+}
+
+//==============================================================================
+int runSchedulerBenchmarks (const juce::StringArray&)
+{
+    const Configuration configurations[] =
+    {
+        { "Soft Sine, soft, 1x",         false, 0 },
+        { "Chorus, Soft Sine, soft, 1x", true,  0 },
+        { "Soft Sine, soft, 2x",         false, 1 },
+        { "Soft Sine, soft, 4x",         false, 2 }
+    };
+
+    const int blockSizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    const auto largestBlockSize = blockSizes[std::size (blockSizes) - 1];
+    const auto input = createInput();
+    bool allMatch = true;
+
+    std::printf ("\nScheduler: %d channels at %.0f Hz, %d sample sub-blocks, best of %d runs\n",
+                 numChannels, sampleRate, Engine::subBlockSize, numRuns);
+    std::printf ("%-28s %6s %10s %12s %10s %9s\n", "configuration", "block", "ns", "vs largest", "staged ns", "matches");
+
+    for (auto& configuration : configurations)
+    {
+        const auto reference = renderFresh (configuration, input, largestBlockSize);
+        const auto largestNs = timeBlockSize (configuration, input, largestBlockSize, false);
+
+        for (auto blockSize : blockSizes)
+        {
+            const auto ns = blockSize == largestBlockSize ? largestNs : timeBlockSize (configuration, input, blockSize, false);
+            const auto stagedNs = timeBlockSize (configuration, input, blockSize, true);
+            const char* matches = "-";
+
+            if (blockSize % Engine::subBlockSize == 0)
+            {
+                const auto identical = isIdentical (renderFresh (configuration, input, blockSize), reference);
+                matches = identical ? "yes" : "NO";
+                allMatch = allMatch && identical;
+            }
+
+            std::printf ("%-28s %6d %10.3f %11.2fx %10.3f %9s\n", configuration.name, blockSize, ns, ns / largestNs, stagedNs, matches);
+        }
+    }
+
+    if (! allMatch)
+    {
+        std::printf ("The output depends on the host's block size\n");
+        return 1;
+    }
+
+    return 0;
+}
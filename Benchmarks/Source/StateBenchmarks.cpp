@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    StateBenchmarks.cpp
+
+    Session save and restore: getStateInformation and setStateInformation
+    for 1000 instances, as a host does opening and saving a large session,
+    in the compact binary format against the XML state it replaced, which
+    is still read for sessions saved before it.
+
+    Each instance gets a state with every continuous parameter changed, so
+    every load has real work to do, then its defaults back, so the next run
+    does too. The times are per instance, best of a few runs.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr int numInstances = 1000;
+    constexpr int numRuns = 5;
+
+    /** Moves every continuous parameter a little way from its default. */
+    void changeParameters (ClipSatAudioProcessor& processor)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (dynamic_cast<juce::AudioParameterFloat*> (parameter) != nullptr)
+                parameter->setValueNotifyingHost (juce::jlimit (0.0f, 1.0f, parameter->getValue() + 0.125f));
+    }
+
+    /** The state getStateInformation wrote before the compact format. */
+    void writeXmlState (ClipSatAudioProcessor& processor, juce::MemoryBlock& destData)
+    {
+        std::unique_ptr<juce::XmlElement> xml (processor.parameters.copyState().createXml());
+        juce::AudioProcessor::copyXmlToBinary (*xml, destData);
+    }
+
+    /** The best of numRuns, in microseconds per instance. */
+    template <typename Fn>
+    double time (Fn&& fn)
+    {
+        // Benchmark::nanosecondsPerSample, with an instance as the sample
+        return Benchmark::nanosecondsPerSample (fn, numInstances, numRuns) * 1.0e-3;
+    }
+
+    void printResult (const char* format, const char* operation, double microseconds, size_t bytes)
+    {
+        std::printf ("%-8s %-6s %12.3f %12.1f %8d\n", format, operation, microseconds, microseconds * numInstances * 1.0e-3, static_cast<int> (bytes));
+    }
+}
+
+//==============================================================================
+int runStateBenchmarks (const juce::StringArray&)
+{
+    juce::OwnedArray<ClipSatAudioProcessor> processors;
+
+    for (int i = 0; i < numInstances; ++i)
+        processors.add (new ClipSatAudioProcessor());
+
+    // The two states every load alternates between, in each format
+    auto& source = *processors.getFirst();
+    juce::MemoryBlock defaultCompact, changedCompact, defaultXml, changedXml;
+
+    source.getStateInformation (defaultCompact);
+    writeXmlState (source, defaultXml);
+    changeParameters (source);
+    source.getStateInformation (changedCompact);
+    writeXmlState (source, changedXml);
+    source.setStateInformation (defaultCompact.getData(), static_cast<int> (defaultCompact.getSize()));
+
+    std::printf ("\nState: save and restore for %d instances, best of %d runs\n", numInstances, numRuns);
+    std::printf ("%-8s %-6s %12s %12s %8s\n", "format", "op", "us/instance", "ms total", "bytes");
+
+    auto timeLoads = [&] (const char* format, const juce::MemoryBlock& changed, const juce::MemoryBlock& defaults)
+    {
+        bool changedNext = true;
+
+        const auto microseconds = time ([&]
+        {
+            const auto& state = changedNext ? changed : defaults;
+
+            for (auto* processor : processors)
+                processor->setStateInformation (state.getData(), static_cast<int> (state.getSize()));
+
+            changedNext = ! changedNext;
+            Benchmark::sink = Benchmark::sink + processors.getLast()->getParameters().getFirst()->getValue();
+        });
+
+        printResult (format, "load", microseconds, changed.getSize());
+    };
+
+    auto timeSaves = [&] (const char* format, auto&& save)
+    {
+        juce::MemoryBlock destData;
+
+        const auto microseconds = time ([&]
+        {
+            for (auto* processor : processors)
+                save (*processor, destData);
+
+            Benchmark::sink = Benchmark::sink + static_cast<float> (destData.getSize());
+        });
+
+        printResult (format, "save", microseconds, destData.getSize());
+    };
+
+    timeLoads ("compact", changedCompact, defaultCompact);
+    timeLoads ("xml", changedXml, defaultXml);
+
+    timeSaves ("compact", [] (ClipSatAudioProcessor& processor, juce::MemoryBlock& destData) { processor.getStateInformation (destData); });
+    timeSaves ("xml", [] (ClipSatAudioProcessor& processor, juce::MemoryBlock& destData) { writeXmlState (processor, destData); });
+
+    // Both formats restore the same values
+    auto& check = *processors.getLast();
+    juce::MemoryBlock fromCompact, fromXml;
+
+    check.setStateInformation (changedCompact.getData(), static_cast<int> (changedCompact.getSize()));
+    check.getStateInformation (fromCompact);
+    check.setStateInformation (defaultCompact.getData(), static_cast<int> (defaultCompact.getSize()));
+    check.setStateInformation (changedXml.getData(), static_cast<int> (changedXml.getSize()));
+    check.getStateInformation (fromXml);
+
+    const bool matches = fromCompact == fromXml;
+    std::printf ("\nCompact and XML restore the same state: %s\n", matches ? "yes" : "NO");
+
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    UndoBenchmarks.cpp
+
+    The undo history across a long automated session: 8 hours of 512
+    sample blocks at 48 kHz (--hours for another length), rendered as fast
+    as they go on another thread, with drive, threshold and mix automated
+    every block the way a host plays automation back. Every ten seconds of
+    session time the user drags a control twice in quick succession, on
+    the message thread, as the editor's sliders would.
+
+    The history's size is read after the first session minute and then
+    every session hour. The run passes if the automation recorded nothing,
+    if each pair of drags made one transaction, and if the history never
+    goes over ParameterUndoHistory's cap, so it stays flat once it's full.
+
+  ==============================================================================
+*/
+
+#include "BenchmarkHarness.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512, numChannels = 2;
+    constexpr double secondsBetweenDrags = 10.0;
+
+    const char* const automatedIDs[] = { "drive", "threshold", "mix" };
+
+    // Never the same control twice running, so separate pairs never coalesce
+    const char* const draggedIDs[] = { "inputGain", "tone", "outputGain" };
+
+    /** How hosts play automation back: no gesture, and not on the message thread. */
+    void automate (ClipSatAudioProcessor& processor, const char* parameterID, float normalised)
+    {
+        auto* parameter = processor.parameters.getParameter (parameterID);
+
+        parameter->setValue (normalised);
+        parameter->sendValueChangedMessageToListeners (normalised);
+    }
+
+    /** How an editor slider drags a parameter: a gesture around a few steps. */
+    void drag (ClipSatAudioProcessor& processor, const char* parameterID, float target)
+    {
+        auto* parameter = processor.parameters.getParameter (parameterID);
+        const auto start = parameter->getValue();
+
+        parameter->beginChangeGesture();
+
+        for (int step = 1; step <= 8; ++step)
+            parameter->setValueNotifyingHost (start + (target - start) * static_cast<float> (step) / 8.0f);
+
+        parameter->endChangeGesture();
+    }
+
+    struct Reading
+    {
+        double hours;
+        int numDragPairs, bytes, numTransactions;
+    };
+}
+
+//==============================================================================
+int runUndoBenchmarks (const juce::StringArray& args)
+{
+    const auto hoursIndex = args.indexOf ("--hours");
+    const auto hours = hoursIndex >= 0 ? juce::jmax (0.01, args[hoursIndex + 1].getDoubleValue()) : 8.0;
+
+    const auto numBlocks = static_cast<juce::int64> (hours * 3600.0 * sampleRate / blockSize);
+    const auto blocksBetweenDrags = static_cast<juce::int64> (secondsBetweenDrags * sampleRate / blockSize);
+    const auto blocksPerHour = static_cast<juce::int64> (3600.0 * sampleRate / blockSize);
+    const auto blocksPerMinute = blocksPerHour / 60;
+
+    ClipSatAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    auto& undoManager = processor.getUndoManager();
+    juce::Array<Reading> readings;
+    int numDragPairs = 0;
+
+    // Message thread only, like the history itself
+    auto read = [&] (double atHours)
+    {
+        readings.add ({ atHours, numDragPairs, undoManager.getNumberOfUnitsTakenUpByStoredCommands(),
+                        undoManager.getUndoDescriptions().size() });
+    };
+
+    std::printf ("\nUndo: %.2f hours of automated rendering, %d samples per block at %.0f Hz\n", hours, blockSize, sampleRate);
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    juce::Thread::launch ([&]
+    {
+        juce::AudioBuffer<float> block (numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random (1);
+        juce::int64 numPairsPosted = 0;
+
+        for (juce::int64 i = 0; i < numBlocks; ++i)
+        {
+            const auto phase = static_cast<float> (i % 4096) / 4096.0f;
+
+            for (int id = 0; id < 3; ++id)
+                automate (processor, automatedIDs[id], 0.5f + 0.5f * std::sin (juce::MathConstants<float>::twoPi * (phase + static_cast<float> (id) / 3.0f)));
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                Benchmark::fillRamp (block.getWritePointer (channel), blockSize, 0.5f);
+
+            processor.processBlock (block, midi);
+
+            if ((i + 1) % blocksBetweenDrags == 0)
+            {
+                const auto* parameterID = draggedIDs[numPairsPosted++ % 3];
+                const auto first = random.nextFloat(), second = random.nextFloat();
+
+                juce::MessageManager::callAsync ([&processor, &numDragPairs, parameterID, first, second]
+                {
+                    drag (processor, parameterID, first);
+                    drag (processor, parameterID, second);
+                    ++numDragPairs;
+                });
+            }
+
+            if (i + 1 == blocksPerMinute || (i + 1) % blocksPerHour == 0 || i + 1 == numBlocks)
+            {
+                const auto atHours = static_cast<double> (i + 1) / static_cast<double> (blocksPerHour);
+                juce::MessageManager::callAsync ([&read, atHours] { read (atHours); });
+            }
+        }
+
+        Benchmark::sink = Benchmark::sink + block.getSample (0, 0);
+        juce::MessageManager::callAsync ([] { juce::MessageManager::getInstance()->stopDispatchLoop(); });
+    });
+
+    juce::MessageManager::getInstance()->runDispatchLoop();
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    std::printf ("Rendered in %.1f s, %.0fx real time\n\n", seconds, hours * 3600.0 / seconds);
+    std::printf ("%8s %10s %10s %14s\n", "hours", "drags", "bytes", "transactions");
+
+    if (readings.isEmpty())
+        return 1;
+
+    bool bounded = true;
+
+    for (auto& reading : readings)
+    {
+        std::printf ("%8.2f %10d %10d %14d\n", reading.hours, reading.numDragPairs * 2, reading.bytes, reading.numTransactions);
+        bounded = bounded && reading.bytes <= ParameterUndoHistory::maxBytes;
+    }
+
+    // Before the cap comes into it, each pair of drags is exactly one transaction
+    const auto& first = readings.getReference (0);
+    const bool coalesced = first.numDragPairs > 0 && first.numTransactions == first.numDragPairs;
+
+    std::printf ("\nOne transaction per pair of drags, none for automation: %s\n", coalesced ? "yes" : "NO");
+    std::printf ("History within %d bytes throughout: %s\n", ParameterUndoHistory::maxBytes, bounded ? "yes" : "NO");
+
+    return coalesced && bounded ? 0 : 1;
+}
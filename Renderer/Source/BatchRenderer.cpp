@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+class BatchRenderer::Worker  : public juce::Thread
+{
+public:
+    Worker (const Settings& s, const juce::Array<juce::File>& in, juce::Array<Result>& out, std::atomic<int>& next)
+        : juce::Thread ("Render worker"), settings (s), inputs (in), results (out), nextInput (next)
+    {
+        formats.registerBasicFormats();
+
+        if (! settings.preset.isEmpty())
+            processor.setStateInformation (settings.preset.getData(), static_cast<int> (settings.preset.getSize()));
+    }
+
+    void run() override
+    {
+        // Each file is claimed by exactly one worker, so results needs no lock
+        for (int index = nextInput++; index < inputs.size() && ! threadShouldExit(); index = nextInput++)
+            results.getReference (index) = renderFile (inputs.getReference (index));
+    }
+
+private:
+    Result renderFile (const juce::File& input)
+    {
+        Result result;
+        result.input = input;
+        result.output = settings.outputFolder.getChildFile (input.getFileName());
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (input));
+
+        if (reader == nullptr)
+            return fail (result, "can't read the file");
+
+        const auto numChannels = static_cast<int> (reader->numChannels);
+        const auto sampleRate = reader->sampleRate;
+
+        if (! setChannelLayout (numChannels))
+            return fail (result, juce::String (numChannels) + " channels aren't supported");
+
+        auto* format = formats.findFormatForFileExtension (result.output.getFileExtension());
+        auto writer = createWriter (format, *reader, result.output);
+
+        if (writer == nullptr)
+            return fail (result, "can't create " + result.output.getFullPathName());
+
+        processor.setRateAndBufferSizeDetails (sampleRate, settings.blockSize);
+        processor.prepareToPlay (sampleRate, settings.blockSize);
+
+        // Oversampling delays the output; trim that many samples from the start and
+        // run the same number past the end so the render lines up with the input
+        const auto latency = static_cast<juce::int64> (processor.getLatencySamples());
+        const auto length = reader->lengthInSamples;
+        auto samplesToTrim = latency;
+
+        juce::AudioBuffer<float> buffer (numChannels, settings.blockSize);
+        juce::MidiBuffer midi;
+
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 position = 0; position < length + latency; position += settings.blockSize)
+        {
+            const auto numSamples = static_cast<int> (juce::jmin (static_cast<juce::int64> (settings.blockSize), length + latency - position));
+            const auto numToRead = static_cast<int> (juce::jlimit (static_cast<juce::int64> (0), static_cast<juce::int64> (numSamples), length - position));
+
+            buffer.clear();
+
+            if (numToRead > 0)
+                reader->read (&buffer, 0, numToRead, position, true, true);
+
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), numChannels, numSamples);
+            processor.processBlock (block, midi);
+
+            const auto trim = static_cast<int> (juce::jmin (samplesToTrim, static_cast<juce::int64> (numSamples)));
+            samplesToTrim -= trim;
+
+            if (! writer->writeFromAudioSampleBuffer (block, trim, numSamples - trim))
+                return fail (result, "can't write " + result.output.getFullPathName());
+        }
+
+        writer.reset();
+        processor.releaseResources();
+
+        result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+        result.audioSeconds = static_cast<double> (length) / sampleRate;
+        return result;
+    }
+
+    bool setChannelLayout (int numChannels)
+    {
+        const auto channelSet = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channelSet);
+        layout.outputBuses.add (channelSet);
+
+        processor.releaseResources();
+        return processor.setBusesLayout (layout);
+    }
+
+    // Same format, rate and channels as the input, at its bit depth where the format allows it
+    static std::unique_ptr<juce::AudioFormatWriter> createWriter (juce::AudioFormat* format, const juce::AudioFormatReader& reader,
+                                                                  const juce::File& file)
+    {
+        if (format == nullptr)
+            return {};
+
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+
+        if (! stream->openedOk())
+            return {};
+
+        const auto bitDepths = format->getPossibleBitDepths();
+        const auto bitDepth = bitDepths.contains (static_cast<int> (reader.bitsPerSample)) ? static_cast<int> (reader.bitsPerSample) : 24;
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), reader.sampleRate, reader.numChannels,
+                                                                                  bitDepth, reader.metadataValues, 0));
+        if (writer != nullptr)
+            stream.release(); // Now owned by the writer
+
+        return writer;
+    }
+
+    static Result fail (Result& result, const juce::String& error)
+    {
+        result.error = error;
+        return result;
+    }
+
+    const Settings& settings;
+    const juce::Array<juce::File>& inputs;
+    juce::Array<Result>& results;
+    std::atomic<int>& nextInput;
+
+    juce::AudioFormatManager formats;
+    ClipSatAudioProcessor processor;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+BatchRenderer::BatchRenderer (Settings settingsToUse)
+    : settings (std::move (settingsToUse))
+{
+}
+
+BatchRenderer::~BatchRenderer() = default;
+
+juce::Array<BatchRenderer::Result> BatchRenderer::render (const juce::Array<juce::File>& inputs)
+{
+    juce::Array<Result> results;
+    results.resize (inputs.size());
+
+    std::atomic<int> nextInput { 0 };
+    juce::OwnedArray<Worker> workers;
+
+    for (int i = 0; i < juce::jlimit (1, juce::jmax (1, inputs.size()), settings.numThreads); ++i)
+        workers.add (new Worker (settings, inputs, results, nextInput));
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    return results;
+}
+
+bool BatchRenderer::loadPreset (const juce::File& file, juce::MemoryBlock& state, juce::String& error)
+{
+    if (! file.existsAsFile())
+    {
+        error = "can't find " + file.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::XmlElement> xml;
+
+    if (file.hasFileExtension ("json"))
+    {
+        // { "drive": 4.0, "saturationMode": 2, ... } in the parameters' own units,
+        // turned into the same tree the processor saves
+        const auto json = juce::JSON::parse (file);
+
+        if (auto* properties = json.getDynamicObject())
+        {
+            xml = std::make_unique<juce::XmlElement> ("Parameters");
+
+            for (auto& property : properties->getProperties())
+            {
+                auto* parameter = xml->createNewChildElement ("PARAM");
+                parameter->setAttribute ("id", property.name.toString());
+                parameter->setAttribute ("value", static_cast<double> (property.value));
+            }
+        }
+    }
+    else
+    {
+        xml = juce::parseXML (file);
+    }
+
+    if (xml == nullptr)
+    {
+        error = "can't parse " + file.getFullPathName();
+        return false;
+    }
+
+    juce::AudioProcessor::copyXmlToBinary (*xml, state);
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.h
+
+    Offline rendering of audio files through ClipSatAudioProcessor, with no
+    editor. Files are spread over a number of worker threads, each of which
+    owns one processor instance, and every file is streamed through in
+    fixed-size blocks so memory use doesn't depend on its length.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ClipSatAudioProcessor;
+
+class BatchRenderer
+{
+public:
+    struct Settings
+    {
+        juce::File outputFolder;
+        juce::MemoryBlock preset;   // State for setStateInformation, or empty for the defaults
+        int blockSize = 512;
+        int numThreads = 1;
+    };
+
+    struct Result
+    {
+        juce::File input, output;
+        juce::String error;         // Empty on success
+        double audioSeconds = 0.0;
+        double renderSeconds = 0.0;
+
+        /** Render time over audio time: below 1 is faster than real time. */
+        double getRealTimeFactor() const noexcept    { return audioSeconds > 0.0 ? renderSeconds / audioSeconds : 0.0; }
+    };
+
+    explicit BatchRenderer (Settings settingsToUse);
+    ~BatchRenderer();
+
+    /** Renders every input into the output folder, under the same file name,
+        and returns one result per input in the same order. Call this from the
+        message thread: the processors are created and destroyed on it.
+    */
+    juce::Array<Result> render (const juce::Array<juce::File>& inputs);
+
+    /** Reads a preset into processor state. The file can be the processor's
+        parameter state as XML, or a JSON object of parameter ID to value.
+    */
+    static bool loadPreset (const juce::File& file, juce::MemoryBlock& state, juce::String& error);
+
+    /** The file extensions render() can read and write. */
+    static juce::String getWildcardForSupportedFiles()    { return "*.wav;*.aif;*.aiff;*.flac"; }
+
+private:
+    class Worker;
+
+    Settings settings;
+
+    JUCE_DECLARE_NON_COPYABLE (BatchRenderer)
+};
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless batch renderer: runs every supported audio file in a folder (or
+    the files given) through ClipSatAudioProcessor and writes the results to
+    an output folder, reporting the real-time factor of each file.
+
+        ClipSatRenderer --output <folder> [--preset <file.xml|file.json>]
+                        [--threads <n>] [--block-size <n>] <folder or files>...
+
+    The GUI modules are only linked because the processor can create its
+    editor; no window is ever opened, so this runs on servers with no display.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BatchRenderer.h"
+
+namespace
+{
+    int printUsage()
+    {
+        std::printf ("Usage: ClipSatRenderer --output <folder> [--preset <file.xml|file.json>]\n"
+                     "                       [--threads <n>] [--block-size <n>] <folder or files>...\n");
+        return 1;
+    }
+
+    juce::Array<juce::File> findInputs (const juce::ArgumentList& args)
+    {
+        juce::Array<juce::File> inputs;
+
+        for (auto& arg : args.arguments)
+        {
+            if (arg.isOption())
+                continue;
+
+            const auto file = arg.resolveAsFile();
+
+            if (file.isDirectory())
+            {
+                auto children = file.findChildFiles (juce::File::findFiles, false, BatchRenderer::getWildcardForSupportedFiles());
+                children.sort();
+                inputs.addArray (children);
+            }
+            else if (file.existsAsFile())
+            {
+                inputs.add (file);
+            }
+        }
+
+        return inputs;
+    }
+
+    // The arguments that follow an option are its values, not inputs
+    juce::ArgumentList withoutOptionValues (juce::ArgumentList args)
+    {
+        for (auto option : { "--output", "--preset", "--threads", "--block-size" })
+        {
+            const auto index = args.indexOfOption (option);
+
+            if (index >= 0 && index + 1 < args.size())
+                args.arguments.remove (index + 1);
+        }
+
+        return args;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor's parameters need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args (argc, argv);
+
+    if (! args.containsOption ("--output"))
+        return printUsage();
+
+    BatchRenderer::Settings settings;
+    settings.outputFolder = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--output"));
+    settings.numThreads = juce::jmax (1, args.containsOption ("--threads") ? args.getValueForOption ("--threads").getIntValue()
+                                                                             : juce::SystemStats::getNumCpus());
+    settings.blockSize = juce::jmax (1, args.containsOption ("--block-size") ? args.getValueForOption ("--block-size").getIntValue() : 512);
+
+    if (args.containsOption ("--preset"))
+    {
+        juce::String error;
+        const auto preset = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--preset"));
+
+        if (! BatchRenderer::loadPreset (preset, settings.preset, error))
+        {
+            std::printf ("Preset: %s\n", error.toRawUTF8());
+            return 1;
+        }
+    }
+
+    const auto inputs = findInputs (withoutOptionValues (args));
+
+    if (inputs.isEmpty())
+        return printUsage();
+
+    if (! settings.outputFolder.createDirectory())
+    {
+        std::printf ("Can't create %s\n", settings.outputFolder.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    std::printf ("Rendering %d files on %d threads, %d sample blocks\n\n", inputs.size(), settings.numThreads, settings.blockSize);
+
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+    const auto results = BatchRenderer (settings).render (inputs);
+    const auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+    std::printf ("%-40s %10s %10s %10s\n", "file", "audio (s)", "render (s)", "rt factor");
+
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (auto& result : results)
+    {
+        if (result.error.isNotEmpty())
+        {
+            std::printf ("%-40s failed: %s\n", result.input.getFileName().toRawUTF8(), result.error.toRawUTF8());
+            ++numFailed;
+            continue;
+        }
+
+        std::printf ("%-40s %10.2f %10.3f %10.4f\n", result.input.getFileName().toRawUTF8(),
+                     result.audioSeconds, result.renderSeconds, result.getRealTimeFactor());
+        totalAudioSeconds += result.audioSeconds;
+    }
+
+    std::printf ("\n%.2f s of audio in %.2f s wall clock (%.1fx real time), %d failed\n",
+                 totalAudioSeconds, wallSeconds, wallSeconds > 0.0 ? totalAudioSeconds / wallSeconds : 0.0, numFailed);
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,473 @@
+/*
+  ==============================================================================
+
+    AntiderivativeKernels.h
+
+    Antiderivative anti-aliasing (ADAA) for the four saturationMode curves
+    and the soft/hard clipper, as a cheaper alternative to oversampling.
+    Instead of sampling f (x[n]), the first order kernel outputs the average
+    of f over the straight line from x[n-1] to x[n],
+
+        (F1 (x[n]) - F1 (x[n-1])) / (x[n] - x[n-1])
+
+    with F1 the antiderivative of f, and the second order kernel does the
+    same again with F2, the second antiderivative, over x[n-2] to x[n]. That
+    removes most of the aliasing a curve's harmonics cause above Nyquist.
+
+    Where consecutive samples are too close for those divided differences
+    to be well-conditioned, the kernels fall back to f, or F1, at the
+    midpoint, which is what the divided difference tends to. Both branches
+    are evaluated and the result selected, so everything still runs on
+    juce::dsp::SIMDRegister; the division comes from FastMath::divide.
+
+    The first order delays the signal by half a sample and the second order
+    by a whole one, and both roll off the top octave a little: for f (x) = x
+    they reduce to the averages (x[n] + x[n-1]) / 2 and
+    (x[n] + x[n-1] + x[n-2]) / 3. alignBlock() applies that same average to
+    the dry side of a dry/wet mix, so the two sides line up.
+
+    Curves with scalesInput are functions of drive * x and are antialiased
+    in terms of drive * x, which gives the same result with no division by
+    the drive. Their antiderivatives drop constant and linear terms, which
+    cancel in the divided differences, so they stay bounded however far
+    the input drives them. Like SaturationKernels, everything is a template
+    on the sample type, the accuracy tier and the parameter source, and the
+    exact tier runs one sample at a time on libm. The fast tier runs the
+    accurate antiderivatives (see detail::process()).
+
+    The divided differences cost precision: just above the tolerance, the
+    second order in float carries rounding noise of up to about 1e-4 of
+    full scale, around -80 dB. The first order, and double, stay well
+    below that.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include "SaturationKernels.h"
+#include <type_traits>
+
+namespace AntiderivativeKernels
+{
+    /** The antiAliasing parameter's choices. */
+    enum Order
+    {
+        off = 0,
+        firstOrder,
+        secondOrder
+    };
+
+    /** The delay an order adds, in samples at the rate it runs at. */
+    constexpr double getDelaySamples (int order) noexcept    { return 0.5 * order; }
+
+    using FastMath::Accuracy;
+    using FastMath::ScalarOf;
+
+    /** The last two input samples of the previous block, per channel and stage. */
+    template <typename SampleType>
+    struct History
+    {
+        SampleType x1 = 0, x2 = 0;
+
+        void push (const SampleType* samples, int numSamples) noexcept
+        {
+            if (numSamples >= 2)
+            {
+                x2 = samples[numSamples - 2];
+                x1 = samples[numSamples - 1];
+            }
+            else if (numSamples == 1)
+            {
+                x2 = x1;
+                x1 = samples[0];
+            }
+        }
+
+        /** As if the signal had been sitting at x, so the next output is f (x). */
+        void prime (SampleType x) noexcept    { x1 = x2 = x; }
+    };
+
+    namespace detail
+    {
+        namespace sk = SaturationKernels::detail;
+
+        template <typename T>
+        inline T splat (ScalarOf<T> value) noexcept
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                return value;
+            else
+                return T::expand (value);
+        }
+
+        /** Below this distance between two inputs, the divided differences lose more
+            to rounding than the midpoint fallback loses by not antialiasing.
+        */
+        template <typename Scalar>
+        constexpr Scalar tolerance = std::is_same_v<Scalar, float> ? Scalar (2.0e-3) : Scalar (1.0e-5);
+
+        template <typename Scalar>
+        constexpr Scalar sixth = Scalar (1) / Scalar (6);
+    }
+
+    //==============================================================================
+    // The curves: f and its first two antiderivatives, on scalars or registers.
+    // Every one matches the curve SaturationKernels runs for the same mode.
+
+    struct SoftSine
+    {
+        static constexpr bool scalesInput = true;
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T f (T u, P) noexcept     { return FastMath::sin<accuracy> (u); }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F1 (T u, P) noexcept    { return FastMath::sin<accuracy> (u + juce::MathConstants<ScalarOf<T>>::halfPi) * ScalarOf<T> (-1); }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F2 (T u, P) noexcept    { return FastMath::sin<accuracy> (u) * ScalarOf<T> (-1); }
+    };
+
+    struct HardCurve
+    {
+        static constexpr bool scalesInput = false;
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T f (T x, P drive) noexcept     { return SaturationKernels::shape<SaturationKernels::hardCurve, Accuracy::accurate> (x, drive); }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F1 (T x, P drive) noexcept    { return x * x * (x * x * drive * ScalarOf<T> (-0.25) + ScalarOf<T> (0.5)); }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F2 (T x, P drive) noexcept    { return x * x * x * (x * x * drive * ScalarOf<T> (-0.05) + detail::sixth<ScalarOf<T>>); }
+    };
+
+    /** Analog Clip, and the hard clipper with the threshold as its parameter. */
+    struct Clamp
+    {
+        static constexpr bool scalesInput = false;
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T f (T x, P limit) noexcept    { return FastMath::clamp (x, limit * ScalarOf<T> (-1), limit); }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F1 (T x, P limit) noexcept
+        {
+            const auto c = f<accuracy> (x, limit);
+            return x * c - c * c * ScalarOf<T> (0.5);
+        }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F2 (T x, P limit) noexcept
+        {
+            // c^3 / 6 inside the limits; outside, continued with the slope and curvature there
+            const auto c = f<accuracy> (x, limit);
+            const auto e = x - c;
+            return c * c * (c * detail::sixth<ScalarOf<T>> + e * ScalarOf<T> (0.5)) + e * e * c * ScalarOf<T> (0.5);
+        }
+    };
+
+    struct SinoidFold
+    {
+        static constexpr bool scalesInput = true;
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T f (T u, P) noexcept    { return FastMath::fold (u); }
+
+        /** The triangle wave's antiderivative less its mean, pi^2 / 8: a parabola on each
+            segment, opening up on the rising ones and down on the falling ones.
+            fold (u + pi/2) carries both the sign and the distance to the segment's end.
+        */
+        template <Accuracy accuracy, typename T, typename P>
+        static T F1 (T u, P) noexcept
+        {
+            using Scalar = ScalarOf<T>;
+            constexpr auto halfPi = juce::MathConstants<Scalar>::halfPi;
+            return FastMath::fold (u + halfPi) * (FastMath::abs (FastMath::fold (u)) + halfPi) * Scalar (-0.5);
+        }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F2 (T u, P) noexcept
+        {
+            using Scalar = ScalarOf<T>;
+            constexpr auto piSquaredOverEight = juce::MathConstants<Scalar>::pi * juce::MathConstants<Scalar>::pi * Scalar (0.125);
+            const auto v = FastMath::fold (u);
+            return v * (v * v * detail::sixth<Scalar> - piSquaredOverEight);
+        }
+    };
+
+    /** The soft clipper, with the threshold as its parameter. */
+    struct SoftClip
+    {
+        static constexpr bool scalesInput = false;
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T f (T x, P threshold) noexcept
+        {
+            if constexpr (accuracy == Accuracy::exact)
+                return SaturationKernels::softClipReference (x, threshold);
+            else
+                return SaturationKernels::softClip<accuracy> (x, threshold);
+        }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F1 (T x, P threshold) noexcept
+        {
+            using Scalar = ScalarOf<T>;
+            constexpr Scalar one (1), half (0.5);
+            const auto a = x - threshold;
+            const auto b = x + threshold;
+            const auto t2 = threshold * threshold * half;
+
+            auto above = a * (threshold + one) + FastMath::exp<accuracy> (a * -one) + (t2 - one);
+            auto below = b * (threshold + one) * -one - FastMath::exp<accuracy> (b * -one) + (t2 + one);
+
+            return detail::sk::select (detail::sk::greaterThan (x, threshold), above,
+                                       detail::sk::select (detail::sk::lessThan (x, threshold * -one), below, x * x * half));
+        }
+
+        template <Accuracy accuracy, typename T, typename P>
+        static T F2 (T x, P threshold) noexcept
+        {
+            using Scalar = ScalarOf<T>;
+            constexpr Scalar one (1), half (0.5);
+            const auto a = x - threshold;
+            const auto b = x + threshold;
+            const auto t2 = threshold * threshold * half;
+            const auto t3 = threshold * threshold * threshold * detail::sixth<Scalar>;
+
+            auto above = a * a * (threshold + one) * half + a * (t2 - one) - FastMath::exp<accuracy> (a * -one) + (t3 + one);
+            auto below = b * b * (threshold + one) * -half + b * (t2 + one) + FastMath::exp<accuracy> (b * -one) - (t3 + one);
+
+            return detail::sk::select (detail::sk::greaterThan (x, threshold), above,
+                                       detail::sk::select (detail::sk::lessThan (x, threshold * -one), below, x * x * x * detail::sixth<Scalar>));
+        }
+    };
+
+    //==============================================================================
+    /** One sample, or one SIMD register, of the curve antialiased at the given order.
+        x0 is the current input, x1 and x2 the two before it.
+    */
+    template <int order, Accuracy accuracy, typename Curve, typename T, typename P>
+    inline T antialias (T x0, T x1, T x2, P parameter) noexcept
+    {
+        using Scalar = ScalarOf<T>;
+        constexpr Scalar half (0.5), two (2);
+        const auto one = detail::splat<T> (Scalar (1));
+
+        if constexpr (Curve::scalesInput)
+        {
+            x0 = x0 * parameter;
+            x1 = x1 * parameter;
+            x2 = x2 * parameter;
+        }
+
+        auto f  = [&] (T x) { return Curve::template f<accuracy> (x, parameter); };
+        auto F1 = [&] (T x) { return Curve::template F1<accuracy> (x, parameter); };
+        auto F2 = [&] (T x) { return Curve::template F2<accuracy> (x, parameter); };
+        auto isWellConditioned = [] (T delta) { return detail::sk::greaterThan (FastMath::abs (delta), detail::tolerance<Scalar>); };
+
+        if constexpr (order == firstOrder)
+        {
+            const auto delta = x0 - x1;
+            const auto ok = isWellConditioned (delta);
+            const auto y = FastMath::divide (F1 (x0) - F1 (x1), detail::sk::select (ok, delta, one));
+
+            return detail::sk::select (ok, y, f ((x0 + x1) * half));
+        }
+        else
+        {
+            // Divided differences of F2, or F1 at the midpoint where they are ill-conditioned
+            auto dividedDifference = [&] (T a, T b, T F2a, T F2b)
+            {
+                const auto delta = a - b;
+                const auto ok = isWellConditioned (delta);
+                const auto d = FastMath::divide (F2a - F2b, detail::sk::select (ok, delta, one));
+
+                return detail::sk::select (ok, d, F1 ((a + b) * half));
+            };
+
+            const auto F2x0 = F2 (x0), F2x1 = F2 (x1), F2x2 = F2 (x2);
+            const auto d01 = dividedDifference (x0, x1, F2x0, F2x1);
+            const auto d12 = dividedDifference (x1, x2, F2x1, F2x2);
+
+            const auto delta = x0 - x2;
+            const auto ok = isWellConditioned (delta);
+            const auto y = FastMath::divide ((d01 - d12) * two, detail::sk::select (ok, delta, one));
+
+            // With x0 close to x2, the same expansion around their midpoint instead
+            const auto mid = (x0 + x2) * half;
+            const auto midDelta = mid - x1;
+            const auto midOk = isWellConditioned (midDelta);
+            const auto safeMidDelta = detail::sk::select (midOk, midDelta, one);
+            const auto yMid = FastMath::divide ((F1 (mid) + FastMath::divide (F2x1 - F2 (mid), safeMidDelta)) * two, safeMidDelta);
+
+            return detail::sk::select (ok, y, detail::sk::select (midOk, yMid, f ((mid + x1) * half)));
+        }
+    }
+
+    /** Antialiases numSamples of source into destination, which mustn't overlap it.
+        history holds the two samples before source[0]; it isn't advanced here.
+    */
+    template <int order, Accuracy accuracy, typename Curve, typename SampleType, typename Parameter>
+    inline void curveBlock (const SampleType* source, SampleType* destination, int numSamples,
+                            const History<SampleType>& history, Parameter parameter) noexcept
+    {
+        auto input = [&] (int i) { return i >= 0 ? source[i] : (i == -1 ? history.x1 : history.x2); };
+
+        auto processSample = [&] (int i)
+        {
+            destination[i] = antialias<order, accuracy, Curve> (input (i), input (i - 1), input (i - 2), parameter.get (i));
+        };
+
+        int i = 0;
+
+        if constexpr (accuracy != Accuracy::exact)
+        {
+            using Vec = juce::dsp::SIMDRegister<SampleType>;
+            constexpr auto width = static_cast<int> (Vec::size());
+
+            // Scalar until the destination is aligned and far enough in for the body to read source[i - 2]
+            auto head = static_cast<int> (Vec::getNextSIMDAlignedPtr (destination) - destination);
+
+            while (head < 2)
+                head += width;
+
+            head = juce::jmin (head, numSamples);
+
+            for (; i < head; ++i)
+                processSample (i);
+
+            for (; i + width <= numSamples; i += width)
+                antialias<order, accuracy, Curve> (FastMath::loadUnaligned (source + i),
+                                                   FastMath::loadUnaligned (source + i - 1),
+                                                   FastMath::loadUnaligned (source + i - 2),
+                                                   parameter.getRegister (i)).copyToRawArray (destination + i);
+        }
+
+        for (; i < numSamples; ++i)
+            processSample (i);
+    }
+
+    /** What the kernels at this order do to f (x) = x, in place: the dry side of a
+        mix goes through this so it lines up with the antialiased wet side.
+        Advances history past data.
+    */
+    template <typename SampleType>
+    inline void alignBlock (int order, SampleType* data, int numSamples, History<SampleType>& history) noexcept
+    {
+        auto next = history;
+        next.push (data, numSamples);
+
+        // Backwards, so the samples before each one are still the input
+        for (int i = numSamples - 1; i >= 0; --i)
+        {
+            const auto x1 = i >= 1 ? data[i - 1] : history.x1;
+
+            if (order == firstOrder)
+            {
+                data[i] = (data[i] + x1) * SampleType (0.5);
+            }
+            else
+            {
+                const auto x2 = i >= 2 ? data[i - 2] : (i == 1 ? history.x1 : history.x2);
+                data[i] = (data[i] + x1 + x2) * (SampleType (1) / SampleType (3));
+            }
+        }
+
+        history = next;
+    }
+
+    //==============================================================================
+    namespace detail
+    {
+        template <typename Curve, typename SampleType, typename Parameter>
+        inline void process (int order, Accuracy accuracy, const SampleType* source, SampleType* destination, int numSamples,
+                             const History<SampleType>& history, Parameter parameter) noexcept
+        {
+            auto run = [&] (auto orderConstant)
+            {
+                constexpr int o = decltype (orderConstant)::value;
+
+                // The fast exp doesn't quite meet itself where its exponent steps, and the
+                // divided differences would amplify that, so the fast tier runs accurate
+                if (accuracy == Accuracy::exact)
+                    curveBlock<o, Accuracy::exact, Curve> (source, destination, numSamples, history, parameter);
+                else
+                    curveBlock<o, Accuracy::accurate, Curve> (source, destination, numSamples, history, parameter);
+            };
+
+            if (order == secondOrder)
+                run (std::integral_constant<int, secondOrder>());
+            else
+                run (std::integral_constant<int, firstOrder>());
+        }
+
+        template <typename SampleType, typename Parameter>
+        inline void processCurve (int order, int mode, Accuracy accuracy, const SampleType* source, SampleType* destination,
+                                  int numSamples, const History<SampleType>& history, Parameter drive) noexcept
+        {
+            switch (mode)
+            {
+                case SaturationKernels::softSine:   process<SoftSine>   (order, accuracy, source, destination, numSamples, history, drive); break;
+                case SaturationKernels::hardCurve:  process<HardCurve>  (order, accuracy, source, destination, numSamples, history, drive); break;
+                case SaturationKernels::analogClip: process<Clamp>      (order, accuracy, source, destination, numSamples, history, drive); break;
+                case SaturationKernels::sinoidFold: process<SinoidFold> (order, accuracy, source, destination, numSamples, history, drive); break;
+                default: break;
+            }
+        }
+    }
+
+    /** Runs the saturationMode curve over source into destination, antialiased at
+        order (firstOrder or secondOrder).
+    */
+    template <typename SampleType>
+    inline void processBlock (int order, int mode, Accuracy accuracy, const SampleType* source, SampleType* destination,
+                              int numSamples, const History<SampleType>& history, SampleType drive) noexcept
+    {
+        detail::processCurve (order, mode, accuracy, source, destination, numSamples, history, SaturationKernels::detail::Constant<SampleType> { drive });
+    }
+
+    /** As above, with the drive given per sample (a smoothing ramp). */
+    template <typename SampleType>
+    inline void processBlock (int order, int mode, Accuracy accuracy, const SampleType* source, SampleType* destination,
+                              int numSamples, const History<SampleType>& history, const SampleType* drive) noexcept
+    {
+        detail::processCurve (order, mode, accuracy, source, destination, numSamples, history, SaturationKernels::detail::Ramp<SampleType> { drive });
+    }
+
+    /** The soft clipper, antialiased. */
+    template <typename SampleType>
+    inline void softClipBlock (int order, Accuracy accuracy, const SampleType* source, SampleType* destination,
+                               int numSamples, const History<SampleType>& history, SampleType threshold) noexcept
+    {
+        detail::process<SoftClip> (order, accuracy, source, destination, numSamples, history, SaturationKernels::detail::Constant<SampleType> { threshold });
+    }
+
+    /** As above, with the threshold given per sample (a smoothing ramp). */
+    template <typename SampleType>
+    inline void softClipBlock (int order, Accuracy accuracy, const SampleType* source, SampleType* destination,
+                               int numSamples, const History<SampleType>& history, const SampleType* threshold) noexcept
+    {
+        detail::process<SoftClip> (order, accuracy, source, destination, numSamples, history, SaturationKernels::detail::Ramp<SampleType> { threshold });
+    }
+
+    /** The hard clipper, antialiased. Its curve has no transcendentals, so there is no accuracy tier. */
+    template <typename SampleType>
+    inline void hardClipBlock (int order, const SampleType* source, SampleType* destination,
+                               int numSamples, const History<SampleType>& history, SampleType threshold) noexcept
+    {
+        detail::process<Clamp> (order, Accuracy::accurate, source, destination, numSamples, history, SaturationKernels::detail::Constant<SampleType> { threshold });
+    }
+
+    /** As above, with the threshold given per sample (a smoothing ramp). */
+    template <typename SampleType>
+    inline void hardClipBlock (int order, const SampleType* source, SampleType* destination,
+                               int numSamples, const History<SampleType>& history, const SampleType* threshold) noexcept
+    {
+        detail::process<Clamp> (order, Accuracy::accurate, source, destination, numSamples, history, SaturationKernels::detail::Ramp<SampleType> { threshold });
+    }
+}
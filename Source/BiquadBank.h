@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    BiquadBank.h
+
+    A set of second order IIR filters that share one set of coefficients:
+    the chorus's low-pass filters, one for every channel group. Each
+    filter's state is a SIMD register with one channel in every lane (see
+    ChannelGroups.h), so a call filters a whole group, and any filters a
+    group has are run back to back on the same coefficients.
+
+    The coefficients only change at block boundaries. setTarget() works
+    them out once for the block, and every filter ramps to them linearly
+    across it, which is stable for any two low-passes: the region of
+    stable (a1, a2) pairs is convex. Settled, the ramp's step is zero and
+    each sample is exactly what juce::dsp::IIR::Filter computes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspArena.h"
+
+template <typename SampleType>
+class BiquadBank
+{
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+
+    /** Normalised so a0 is 1, in the order of juce::dsp::IIR::Coefficients. */
+    struct Coefficients
+    {
+        SampleType b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    };
+
+    /** Transposed direct form II, in the same order as juce::dsp::IIR::Filter. */
+    struct State
+    {
+        Register s1 = Register::expand (0), s2 = Register::expand (0);
+
+        Register process (const Coefficients& c, Register input) noexcept
+        {
+            const auto output = input * c.b0 + s1;
+            s1 = input * c.b1 - output * c.a1 + s2;
+            s2 = input * c.b2 - output * c.a2;
+            return output;
+        }
+    };
+
+    /** What juce::dsp::IIR::Coefficients::makeLowPass gives, with a Q of 1 / sqrt (2),
+        without allocating.
+    */
+    static Coefficients makeLowPass (double sampleRate, SampleType frequency) noexcept
+    {
+        const auto n = 1 / std::tan (juce::MathConstants<SampleType>::pi * frequency / static_cast<SampleType> (sampleRate));
+        const auto nSquared = n * n;
+        const auto invQ = 1 / static_cast<SampleType> (juce::MathConstants<double>::sqrt2 * 0.5);
+        const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+        return { c1, c1 * 2, c1, c1 * 2 * (1 - nSquared), c1 * (1 - invQ * n + nSquared) };
+    }
+
+    //==============================================================================
+    /** Allocates numFilters cleared states for each of numGroups channel groups from arena. */
+    void prepare (int numGroups, int numFiltersPerGroup, DspArena& arena)
+    {
+        numFilters = juce::jmax (1, numFiltersPerGroup);
+        numStates = juce::jmax (1, numGroups) * numFilters;
+        states = arena.allocate<State> (DspArena::filters, numStates);
+    }
+
+    void reset() noexcept
+    {
+        if (states != nullptr)
+            std::fill (states, states + numStates, State());
+    }
+
+    /** Jumps straight to newCoefficients. */
+    void setCoefficients (const Coefficients& newCoefficients) noexcept
+    {
+        start = newCoefficients;
+        step = { 0, 0, 0, 0, 0 };
+    }
+
+    /** Ramps from the current coefficients to target across the next numSamples. */
+    void setTarget (const Coefficients& target, int numSamples) noexcept
+    {
+        const auto scale = SampleType (1) / static_cast<SampleType> (juce::jmax (1, numSamples));
+
+        step = { (target.b0 - start.b0) * scale, (target.b1 - start.b1) * scale, (target.b2 - start.b2) * scale,
+                 (target.a1 - start.a1) * scale, (target.a2 - start.a2) * scale };
+        end = target;
+        ramping = true;
+    }
+
+    /** Ends the block every group has just processed. */
+    void advance() noexcept
+    {
+        if (ramping)
+            setCoefficients (end);
+
+        ramping = false;
+    }
+
+    //==============================================================================
+    /** The coefficients for sample i of the current block. */
+    Coefficients getCoefficients (int i) const noexcept
+    {
+        const auto t = static_cast<SampleType> (i + 1);
+        return { start.b0 + step.b0 * t, start.b1 + step.b1 * t, start.b2 + step.b2 * t,
+                 start.a1 + step.a1 * t, start.a2 + step.a2 * t };
+    }
+
+    /** The group's filters, one after the other. */
+    State* getStates (int group) noexcept    { return states + group * numFilters; }
+
+private:
+    State* states = nullptr; // In the arena
+    int numFilters = 1, numStates = 0;
+    Coefficients start, step { 0, 0, 0, 0, 0 }, end;
+    bool ramping = false;
+};
@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    BypassFader.h
+
+    Crossfades between the processed signal and the dry input when the host
+    bypasses the plugin or brings it back. The dry input is delayed by the
+    reported latency, so bypassing doesn't shift the track in time and the
+    two sides of the fade line up.
+
+    Every block's input is recorded, since a fade out needs the dry signal
+    from before it started. Once the fade to bypass has finished, the wet
+    path isn't run at all and a block costs two copies per channel.
+
+    Both buffers are in the instance's DspArena, so the fader never
+    allocates on the audio thread: blocks longer than the prepared size
+    have to be split up by the caller.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspArena.h"
+#include <vector>
+
+template <typename SampleType>
+class BypassFader
+{
+public:
+    static constexpr double fadeMs = 10.0;
+
+    /** Allocates the dry delay line from arena for blocks of up to maximumBlockSize
+        samples and up to maximumLatency samples of delay.
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int maximumLatency, int numChannels, DspArena& arena)
+    {
+        fadeStep = static_cast<SampleType> (1000.0 / (fadeMs * sampleRate));
+        maxLatency = maximumLatency;
+
+        // A power of two, so the read and write positions wrap with a mask
+        const auto size = juce::nextPowerOfTwo (maxLatency + maximumBlockSize + 1);
+        std::vector<SampleType*> delayChannels, dryChannels;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            delayChannels.push_back (arena.allocate<SampleType> (DspArena::bypass, size));
+            dryChannels.push_back (arena.allocate<SampleType> (DspArena::bypass, maximumBlockSize));
+        }
+
+        if (arena.isMeasuring() || numChannels <= 0)
+            return;
+
+        delayLine.setDataToReferTo (delayChannels.data(), numChannels, size);
+        dryBuffer.setDataToReferTo (dryChannels.data(), numChannels, maximumBlockSize);
+        mask = size - 1;
+        reset();
+    }
+
+    /** Forgets the arena's memory, before it is freed. */
+    void release() noexcept
+    {
+        delayLine = {};
+        dryBuffer = {};
+        writeIndex = mask = 0;
+        bypassAmount = 0;
+    }
+
+    /** Clears the dry signal and jumps to fully active. */
+    void reset() noexcept
+    {
+        delayLine.clear();
+        writeIndex = 0;
+        bypassAmount = 0;
+    }
+
+    /** True once a fade to bypass has finished, so the wet path has stopped running. */
+    bool isFullyBypassed() const noexcept    { return bypassAmount == 1; }
+
+    /** Processes the first numSamples of each channel in place, calling processWet()
+        to run the plugin on buffer unless it is fully bypassed. latency is the
+        delay processWet() introduces, and bypassed the host's current state.
+        numSamples, latency and numChannels mustn't be more than prepare() was given.
+    */
+    template <typename ProcessWet>
+    void process (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples, int latency, bool bypassed,
+                  ProcessWet&& processWet)
+    {
+        jassert (numSamples <= dryBuffer.getNumSamples() && latency <= maxLatency && numChannels <= delayLine.getNumChannels());
+
+        writeDry (buffer, numChannels, numSamples);
+
+        const SampleType target = bypassed ? 1 : 0;
+
+        if (bypassed && isFullyBypassed())
+        {
+            readDry (buffer, numChannels, numSamples, latency);
+            return;
+        }
+
+        processWet();
+
+        if (bypassAmount == target)
+            return;
+
+        // Mid-fade: wet + bypassAmount * (dry - wet), with bypassAmount moving linearly
+        readDry (dryBuffer, numChannels, numSamples, latency);
+        const auto step = bypassed ? fadeStep : -fadeStep;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* wet = buffer.getWritePointer (channel);
+            const auto* dry = dryBuffer.getReadPointer (channel);
+            auto amount = bypassAmount;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                amount = juce::jlimit (SampleType (0), SampleType (1), amount + step);
+                wet[i] += amount * (dry[i] - wet[i]);
+            }
+        }
+
+        bypassAmount = juce::jlimit (SampleType (0), SampleType (1), bypassAmount + step * static_cast<SampleType> (numSamples));
+    }
+
+private:
+    void writeDry (const juce::AudioBuffer<SampleType>& source, int numChannels, int numSamples) noexcept
+    {
+        const auto first = juce::jmin (numSamples, delayLine.getNumSamples() - writeIndex);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            delayLine.copyFrom (channel, writeIndex, source, channel, 0, first);
+            delayLine.copyFrom (channel, 0, source, channel, first, numSamples - first);
+        }
+
+        writeIndex = (writeIndex + numSamples) & mask;
+    }
+
+    /** The numSamples just written, delayed by latency. */
+    void readDry (juce::AudioBuffer<SampleType>& destination, int numChannels, int numSamples, int latency) const noexcept
+    {
+        const auto readIndex = (writeIndex - numSamples - latency) & mask;
+        const auto first = juce::jmin (numSamples, delayLine.getNumSamples() - readIndex);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            destination.copyFrom (channel, 0, delayLine, channel, readIndex, first);
+            destination.copyFrom (channel, first, delayLine, channel, 0, numSamples - first);
+        }
+    }
+
+    juce::AudioBuffer<SampleType> delayLine; // The dry input, per channel, referring to the arena
+    juce::AudioBuffer<SampleType> dryBuffer; // The delayed dry signal during a fade, likewise
+    int writeIndex = 0, mask = 0, maxLatency = 0;
+
+    SampleType bypassAmount = 0; // 0 is fully active, 1 fully bypassed
+    SampleType fadeStep = 0;
+};
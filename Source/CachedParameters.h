@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    CachedParameters.h
+
+    Reads the processor's parameters into a ParameterSnapshot once at the
+    start of each block. The parameters' atomics are resolved by ID once,
+    at construction, so the audio thread never does a string lookup;
+    update() then does one relaxed load per parameter. Values derived from
+    a parameter, such as the threshold as a gain, are only recomputed when
+    that parameter changes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+
+class CachedParameters
+{
+public:
+    explicit CachedParameters (juce::AudioProcessorValueTreeState& state)
+        : inputGain          (get (state, "inputGain")),
+          outputGain         (get (state, "outputGain")),
+          threshold          (get (state, "threshold")),
+          drive              (get (state, "drive")),
+          dryWet             (get (state, "dryWet")),
+          rate               (get (state, "rate")),
+          depth              (get (state, "depth")),
+          mix                (get (state, "mix")),
+          tone               (get (state, "tone")),
+          spread             (get (state, "spread")),
+          chorusVoices       (get (state, "chorusVoices")),
+          chorusOnOff        (get (state, "chorusOnOff")),
+          satOnOff           (get (state, "satOnOff")),
+          clipperOnOff       (get (state, "clipperOnOff")),
+          softClipping       (get (state, "softClipping")),
+          saturationMode     (get (state, "saturationMode")),
+          oversampling       (get (state, "oversampling")),
+          oversamplingFilter (get (state, "oversamplingFilter")),
+          accuracy           (get (state, "accuracy")),
+          chorusInterpolation (get (state, "chorusInterpolation")),
+          antiAliasing       (get (state, "antiAliasing"))
+    {
+        update();
+    }
+
+    /** Reads every parameter into the snapshot and returns it. */
+    const ParameterSnapshot& update() noexcept
+    {
+        snapshot.inputGain = load (inputGain);
+        snapshot.outputGain = load (outputGain);
+        snapshot.drive = load (drive);
+        snapshot.dryWet = load (dryWet);
+        snapshot.rate = load (rate);
+        snapshot.depth = load (depth);
+        snapshot.mix = load (mix);
+        snapshot.tone = load (tone);
+        snapshot.spread = load (spread);
+
+        const auto thresholdDecibels = load (threshold);
+
+        if (thresholdDecibels != snapshot.thresholdDecibels || ! thresholdGainValid)
+        {
+            snapshot.thresholdDecibels = thresholdDecibels;
+            snapshot.thresholdGain = juce::Decibels::decibelsToGain (thresholdDecibels);
+            thresholdGainValid = true;
+        }
+
+        snapshot.chorusOn = load (chorusOnOff) > 0.5f;
+        snapshot.satOn = load (satOnOff) > 0.5f;
+        snapshot.clipperOn = load (clipperOnOff) > 0.5f;
+        snapshot.softClipping = load (softClipping) > 0.5f;
+        snapshot.saturationMode = static_cast<int> (load (saturationMode));
+        snapshot.chorusVoices = static_cast<int> (load (chorusVoices));
+        snapshot.oversamplingStages = static_cast<int> (load (oversampling));
+        snapshot.oversamplingFilter = static_cast<int> (load (oversamplingFilter));
+        snapshot.accuracy = static_cast<FastMath::Accuracy> (static_cast<int> (load (accuracy)));
+        snapshot.chorusInterpolation = static_cast<ChorusInterpolation> (static_cast<int> (load (chorusInterpolation)));
+        snapshot.antiAliasing = static_cast<int> (load (antiAliasing));
+
+        return snapshot;
+    }
+
+    /** The snapshot taken by the last update(). */
+    const ParameterSnapshot& getSnapshot() const noexcept    { return snapshot; }
+
+private:
+    static std::atomic<float>& get (juce::AudioProcessorValueTreeState& state, const char* parameterID)
+    {
+        auto* value = state.getRawParameterValue (parameterID);
+        jassert (value != nullptr);
+        return *value;
+    }
+
+    static float load (const std::atomic<float>& value) noexcept
+    {
+        return value.load (std::memory_order_relaxed);
+    }
+
+    std::atomic<float>& inputGain;
+    std::atomic<float>& outputGain;
+    std::atomic<float>& threshold;
+    std::atomic<float>& drive;
+    std::atomic<float>& dryWet;
+    std::atomic<float>& rate;
+    std::atomic<float>& depth;
+    std::atomic<float>& mix;
+    std::atomic<float>& tone;
+    std::atomic<float>& spread;
+    std::atomic<float>& chorusVoices;
+    std::atomic<float>& chorusOnOff;
+    std::atomic<float>& satOnOff;
+    std::atomic<float>& clipperOnOff;
+    std::atomic<float>& softClipping;
+    std::atomic<float>& saturationMode;
+    std::atomic<float>& oversampling;
+    std::atomic<float>& oversamplingFilter;
+    std::atomic<float>& accuracy;
+    std::atomic<float>& chorusInterpolation;
+    std::atomic<float>& antiAliasing;
+
+    ParameterSnapshot snapshot;
+    bool thresholdGainValid = false;
+
+    JUCE_DECLARE_NON_COPYABLE (CachedParameters)
+};
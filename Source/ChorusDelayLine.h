@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    ChorusDelayLine.h
+
+    The chorus delay line and its LFO.
+
+    ChorusDelayLine keeps one power-of-two circular buffer per channel group
+    (see ChannelGroups.h), sized to the largest modulated delay rather than
+    to seconds of audio, in the instance's DspArena. Each slot holds a SIMD register with one channel in
+    every lane, so a tap reads a whole group at once: every channel shares
+    the same modulated delay. Taps are read at fractional delays with
+    linear, 3rd order Lagrange or first order allpass interpolation. It is a
+    template on the sample type, for the float and double processing paths.
+
+    QuadratureOscillator is a recursive sine/cosine oscillator: it only
+    rotates a unit vector, so the LFO costs a handful of multiplies per
+    control step instead of a std::sin per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspArena.h"
+
+enum class ChorusInterpolation
+{
+    linear = 0,
+    lagrange,
+    allpass
+};
+
+//==============================================================================
+template <typename SampleType>
+class ChorusDelayLine
+{
+public:
+    using Interpolation = ChorusInterpolation;
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+
+    /** Allocates the lines from arena, cleared. The buffers hold maximumDelayInSamples
+        plus the interpolator's extra points, rounded up to a power of two.
+    */
+    void prepare (int numGroups, int maximumDelayInSamples, int maximumNumTaps, DspArena& arena)
+    {
+        lineSize = juce::nextPowerOfTwo (maximumDelayInSamples + 4);
+        numTaps = juce::jmax (1, maximumNumTaps);
+        numLines = juce::jmax (1, numGroups);
+
+        lines = arena.allocate<Register> (DspArena::chorus, numLines * lineSize);
+        allpassStates = arena.allocate<Register> (DspArena::chorus, numLines * numTaps);
+        mask = lineSize - 1;
+        maximumDelay = static_cast<SampleType> (maximumDelayInSamples);
+        writeIndex = 0;
+    }
+
+    void reset() noexcept
+    {
+        if (lines == nullptr)
+            return;
+
+        std::fill (lines, lines + numLines * lineSize, Register::expand (0));
+        std::fill (allpassStates, allpassStates + numLines * numTaps, Register::expand (0));
+        writeIndex = 0;
+    }
+
+    /** Moves the write head past the block every group has just processed. */
+    void advance (int numSamples) noexcept
+    {
+        writeIndex = (writeIndex + numSamples) & mask;
+    }
+
+    int getBufferSize() const noexcept     { return lineSize; }
+
+    //==============================================================================
+    /** Per-sample access. Frame i of the current block goes to
+        (getWriteIndex() + i) & getMask() of every group's line.
+    */
+    Register* getLine (int group) noexcept             { return lines + group * lineSize; }
+    Register* getAllpassStates (int group) noexcept    { return allpassStates + group * numTaps; }
+    int getWriteIndex() const noexcept                 { return writeIndex; }
+    int getMask() const noexcept                       { return mask; }
+
+    /** Reads one tap for a whole group at a fractional delay behind index.
+        state is the tap's allpass state, and is only touched by allpass
+        interpolation.
+    */
+    template <Interpolation interpolation>
+    Register read (const Register* line, int index, SampleType delay, Register& state) const noexcept
+    {
+        delay = juce::jlimit (SampleType (0), maximumDelay, delay);
+
+        if constexpr (interpolation == Interpolation::lagrange)
+        {
+            // Four points around the read position, centred on the fractional part
+            delay = juce::jmax (SampleType (1), delay);
+            auto delayInt = static_cast<int> (delay) - 1;
+            auto frac = delay - static_cast<SampleType> (delayInt);
+
+            auto value1 = line[(index - delayInt) & mask];
+            auto value2 = line[(index - delayInt - 1) & mask];
+            auto value3 = line[(index - delayInt - 2) & mask];
+            auto value4 = line[(index - delayInt - 3) & mask];
+
+            SampleType d1 = frac - 1.0f;
+            SampleType d2 = frac - 2.0f;
+            SampleType d3 = frac - 3.0f;
+
+            SampleType c1 = -d1 * d2 * d3 / 6.0f;
+            SampleType c2 = d2 * d3 * 0.5f;
+            SampleType c3 = -d1 * d3 * 0.5f;
+            SampleType c4 = d1 * d2 / 6.0f;
+
+            return value1 * c1 + (value2 * c2 + value3 * c3 + value4 * c4) * frac;
+        }
+        else if constexpr (interpolation == Interpolation::allpass)
+        {
+            auto delayInt = static_cast<int> (delay);
+            auto frac = delay - static_cast<SampleType> (delayInt);
+
+            // Keep the fractional delay in [0.618, 1.618), away from the pole near -1
+            if (frac < 0.618f && delayInt >= 1)
+            {
+                --delayInt;
+                frac += 1.0f;
+            }
+
+            auto value1 = line[(index - delayInt) & mask];
+            auto value2 = line[(index - delayInt - 1) & mask];
+            SampleType alpha = (1.0f - frac) / (1.0f + frac);
+
+            state = value2 + (value1 - state) * alpha;
+            return state;
+        }
+        else
+        {
+            auto delayInt = static_cast<int> (delay);
+            auto frac = delay - static_cast<SampleType> (delayInt);
+
+            auto value1 = line[(index - delayInt) & mask];
+            auto value2 = line[(index - delayInt - 1) & mask];
+
+            return value1 + (value2 - value1) * frac;
+        }
+    }
+
+private:
+    Register* lines = nullptr;         // numLines * lineSize, in the arena
+    Register* allpassStates = nullptr; // numLines * numTaps, in the arena
+    int lineSize = 1, numTaps = 1, numLines = 0;
+    int mask = 0;
+    int writeIndex = 0;
+    SampleType maximumDelay = 0;
+};
+
+//==============================================================================
+class QuadratureOscillator
+{
+public:
+    /** Sets the frequency, and how many samples each call to step() covers. */
+    void setFrequency (float frequencyHz, double sampleRate, int samplesPerStep) noexcept
+    {
+        auto angle = juce::MathConstants<double>::twoPi * frequencyHz * samplesPerStep / sampleRate;
+        rotationCos = static_cast<float> (std::cos (angle));
+        rotationSin = static_cast<float> (std::sin (angle));
+    }
+
+    void reset (float phase = 0.0f) noexcept
+    {
+        cosValue = std::cos (phase);
+        sinValue = std::sin (phase);
+    }
+
+    /** Advances by one step, and pulls the vector back onto the unit circle so
+        rounding errors can't make the amplitude drift.
+    */
+    void step() noexcept
+    {
+        auto c = cosValue * rotationCos - sinValue * rotationSin;
+        auto s = sinValue * rotationCos + cosValue * rotationSin;
+        auto gain = 1.5f - 0.5f * (c * c + s * s);
+
+        cosValue = c * gain;
+        sinValue = s * gain;
+    }
+
+    float getSin() const noexcept   { return sinValue; }
+    float getCos() const noexcept   { return cosValue; }
+
+private:
+    float cosValue = 1.0f, sinValue = 0.0f;
+    float rotationCos = 1.0f, rotationSin = 0.0f;
+};
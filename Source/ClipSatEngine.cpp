@@ -0,0 +1,817 @@
+/*
+  ==============================================================================
+
+    ClipSatEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "ClipSatEngine.h"
+#include "CpuDispatch.h"
+#include <algorithm>
+
+namespace
+{
+    using ChannelType = juce::AudioChannelSet::ChannelType;
+
+    // The left and right channels of every pair a surround layout can have. The
+    // centre channels, the LFE and discrete channels aren't on either side.
+    constexpr std::pair<ChannelType, ChannelType> stereoPairs[] =
+    {
+        { juce::AudioChannelSet::left,              juce::AudioChannelSet::right },
+        { juce::AudioChannelSet::leftSurround,      juce::AudioChannelSet::rightSurround },
+        { juce::AudioChannelSet::leftCentre,        juce::AudioChannelSet::rightCentre },
+        { juce::AudioChannelSet::leftSurroundSide,  juce::AudioChannelSet::rightSurroundSide },
+        { juce::AudioChannelSet::leftSurroundRear,  juce::AudioChannelSet::rightSurroundRear },
+        { juce::AudioChannelSet::wideLeft,          juce::AudioChannelSet::wideRight },
+        { juce::AudioChannelSet::topFrontLeft,      juce::AudioChannelSet::topFrontRight },
+        { juce::AudioChannelSet::topRearLeft,       juce::AudioChannelSet::topRearRight },
+        { juce::AudioChannelSet::topSideLeft,       juce::AudioChannelSet::topSideRight }
+    };
+}
+
+//==============================================================================
+template <typename SampleType>
+ClipSatEngine<SampleType>::ClipSatEngine() = default;
+
+template <typename SampleType>
+ClipSatEngine<SampleType>::~ClipSatEngine() = default;
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::prepare (double newSampleRate, int samplesPerBlock, int numChannels, const Params& params,
+                                         const juce::AudioChannelSet& layout)
+{
+    ownArena.layOut ([&] (DspArena& arena) { prepare (newSampleRate, samplesPerBlock, numChannels, params, arena, layout); });
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::prepare (double newSampleRate, int samplesPerBlock, int numChannels, const Params& params, DspArena& arena,
+                                         const juce::AudioChannelSet& layout)
+{
+    jassert (numChannels <= maxNumChannels);
+
+    sampleRate = newSampleRate;
+    numPreparedChannels = numChannels;
+    numGroups = ChannelGroups::getNumGroups<SampleType> (numChannels);
+    subBlockLength = juce::jlimit (1, subBlockSize, samplesPerBlock);
+
+    // Settle which span kernels this CPU gets now, rather than in the first block
+    CpuDispatch::getActiveVariant();
+
+    // Everything from the arena first. Per-channel buffers get a run of the arena per
+    // channel, and the AudioBuffers refer to them once the arena has been allocated.
+    auto allocateChannels = [&] (DspArena::Subsystem subsystem, int channelsToAllocate, int size, SampleType** channelData)
+    {
+        for (int channel = 0; channel < channelsToAllocate; ++channel)
+            channelData[channel] = arena.allocate<SampleType> (subsystem, size);
+    };
+
+    // The chorus delay line only needs to hold the deepest modulation, plus the
+    // ramp across one LFO step
+    const int maxChorusDelay = static_cast<int> (std::ceil (maxChorusDelaySeconds * sampleRate));
+    chorusDelayLine.prepare (numGroups, maxChorusDelay, maxChorusVoices, arena);
+
+    SampleType* chorusScratchChannels[maxChorusVoices] = {};
+    allocateChannels (DspArena::chorus, maxChorusVoices, subBlockLength, chorusScratchChannels);
+    chorusGains = arena.allocate<Register> (DspArena::chorus, numGroups * maxChorusVoices);
+
+    // Every voice goes through the same low-pass, so each channel group only
+    // filters the voices' mix, with its own state in every lane
+    chorusFilters.prepare (numGroups, 1, arena);
+
+    groupFrames = arena.allocate<Register> (DspArena::scratch, subBlockLength);
+
+    // Scratch space for the saturator's wet path and the oversampled parameter ramps,
+    // sized for the highest oversampling factor
+    const int maxOversampledBlock = subBlockLength << maxOversamplingStages;
+    SampleType* wetChannels[maxNumChannels] = {};
+    SampleType* rampChannels[3] = {};
+    allocateChannels (DspArena::scratch, numChannels, maxOversampledBlock, wetChannels);
+    allocateChannels (DspArena::scratch, 3, maxOversampledBlock, rampChannels);
+
+    for (auto* smoother : { &inputGain, &outputGain, &threshold, &drive, &dryWet })
+        smoother->prepare (sampleRate, levelSmoothingMs, subBlockLength, arena);
+
+    for (auto* smoother : { &chorusRate, &chorusDepth, &chorusTone, &chorusSpread })
+        smoother->prepare (sampleRate, modulationSmoothingMs, subBlockLength, arena);
+
+    chorusMix.prepare (sampleRate, levelSmoothingMs, subBlockLength, arena);
+
+    saturatorHistories = arena.allocate<AntiderivativeKernels::History<SampleType>> (DspArena::antiAliasing, numChannels);
+    clipperHistories = arena.allocate<AntiderivativeKernels::History<SampleType>> (DspArena::antiAliasing, numChannels);
+    historiesPrimed = false;
+
+    // The oversamplers aren't in the arena, but the latency they add sizes the
+    // caller's bypass delay line, so it has to be known while measuring.
+    // Preparing them again for the second pass only resets them.
+    prepareOversamplers (subBlockLength, params);
+
+    if (arena.isMeasuring())
+        return;
+
+    // The arena's memory is cleared; everything from here on starts it off
+    chorusScratch.setDataToReferTo (chorusScratchChannels, maxChorusVoices, subBlockLength);
+    wetBuffer.setDataToReferTo (wetChannels, numChannels, maxOversampledBlock);
+    oversampledRamps.setDataToReferTo (rampChannels, 3, maxOversampledBlock);
+
+    // The first voice starts at phase zero; updateChorusVoices() adds the others
+    chorusLfos[0].reset();
+    chorusLfoCounter = 0;
+    numChorusVoices = 1;
+
+    const float initialDelay = 0.5f * params.depth * 0.02f * static_cast<float> (sampleRate);
+    std::fill (std::begin (chorusDelayFrom), std::end (chorusDelayFrom), initialDelay);
+    std::fill (std::begin (chorusDelayTo), std::end (chorusDelayTo), initialDelay);
+
+    // A channel is only panned if the other side of its pair is there too
+    const auto channelSet = layout.size() == numChannels ? layout : juce::AudioChannelSet::canonicalChannelSet (numChannels);
+    std::fill (std::begin (chorusPanSides), std::end (chorusPanSides), PanSide::centre);
+
+    for (auto& pair : stereoPairs)
+    {
+        const auto leftChannel = channelSet.getChannelIndexForType (pair.first);
+        const auto rightChannel = channelSet.getChannelIndexForType (pair.second);
+
+        if (leftChannel >= 0 && rightChannel >= 0)
+        {
+            chorusPanSides[leftChannel] = PanSide::left;
+            chorusPanSides[rightChannel] = PanSide::right;
+        }
+    }
+
+    chorusGainsChannels = 0;
+
+    chorusFilterTone = static_cast<SampleType> (params.tone);
+    chorusFilters.setCoefficients (getChorusFilter (chorusFilterTone));
+
+    // Every smoother starts settled on its parameter's current value
+    inputGain.setCurrentAndTargetValue (static_cast<SampleType> (params.inputGain));
+    outputGain.setCurrentAndTargetValue (static_cast<SampleType> (params.outputGain));
+    threshold.setCurrentAndTargetValue (static_cast<SampleType> (params.thresholdGain)); // Smoothed as a gain, not in decibels
+    drive.setCurrentAndTargetValue (static_cast<SampleType> (params.drive));
+    dryWet.setCurrentAndTargetValue (static_cast<SampleType> (params.dryWet));
+    chorusRate.setCurrentAndTargetValue (static_cast<SampleType> (params.rate));
+    chorusDepth.setCurrentAndTargetValue (static_cast<SampleType> (params.depth));
+    chorusMix.setCurrentAndTargetValue (static_cast<SampleType> (params.mix));
+    chorusTone.setCurrentAndTargetValue (static_cast<SampleType> (params.tone));
+    chorusSpread.setCurrentAndTargetValue (static_cast<SampleType> (params.spread));
+
+    // The other voices join the first at their phase offsets, with the depth settled
+    updateChorusVoices (params.chorusVoices);
+
+    silentSamples = 0;
+    outputSilent = false;
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::release()
+{
+    chorusDelayLine = {};
+    chorusScratch = {};
+    chorusFilters = {};
+    chorusGains = nullptr;
+    groupFrames = nullptr;
+    saturatorHistories = nullptr;
+    clipperHistories = nullptr;
+    wetBuffer = {};
+    oversampledRamps = {};
+    oversamplers.clear();
+    oversamplerBlockSize = oversamplerChannels = 0;
+    activeOversampler = -1;
+    numPreparedChannels = 0;
+    numGroups = 0;
+    subBlockLength = 0;
+
+    for (auto* smoother : { &inputGain, &outputGain, &threshold, &drive, &dryWet, &chorusRate, &chorusDepth, &chorusMix, &chorusTone, &chorusSpread })
+        *smoother = {};
+
+    ownArena.release();
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::reset()
+{
+    chorusDelayLine.reset();
+
+    chorusFilters.reset();
+
+    for (auto* oversampler : oversamplers)
+        oversampler->reset();
+
+    historiesPrimed = false;
+    silentSamples = 0;
+    outputSilent = false;
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::prepareOversamplers (int samplesPerBlock, const Params& params)
+{
+    // Every factor/filter combination is built up front so switching them from
+    // the audio thread never allocates. Index: filterType * maxOversamplingStages + stages - 1.
+    // They don't depend on the sample rate, so for the same block size and channels
+    // the ones already built are only reset.
+    const auto numChannels = juce::jmax (1, numPreparedChannels);
+
+    if (oversamplers.size() == 2 * maxOversamplingStages && samplesPerBlock == oversamplerBlockSize && numChannels == oversamplerChannels)
+    {
+        for (auto* oversampler : oversamplers)
+            oversampler->reset();
+    }
+    else
+    {
+        oversamplers.clear();
+
+        for (auto filterType : { Oversampling::filterHalfBandPolyphaseIIR, Oversampling::filterHalfBandFIREquiripple })
+        {
+            for (int stages = 1; stages <= maxOversamplingStages; ++stages)
+            {
+                auto* oversampler = oversamplers.add (new Oversampling (static_cast<size_t> (numChannels), static_cast<size_t> (stages), filterType, true, true));
+                oversampler->initProcessing (static_cast<size_t> (samplesPerBlock));
+            }
+        }
+    }
+
+    maxLatencySamples = 0;
+
+    for (auto* oversampler : oversamplers)
+        maxLatencySamples = juce::jmax (maxLatencySamples, juce::roundToInt (oversampler->getLatencyInSamples()));
+
+    // The antialiased saturator and clipper add the most at the host rate
+    maxLatencySamples += juce::roundToInt (2.0 * AntiderivativeKernels::getDelaySamples (AntiderivativeKernels::secondOrder));
+    oversamplerBlockSize = samplesPerBlock;
+    oversamplerChannels = numChannels;
+
+    // Report the latency of the current selection straight away, hosts read it after prepareToPlay
+    auto* selected = getOversampler (params.oversamplingStages, params.oversamplingFilter);
+    activeOversampler = oversamplers.indexOf (selected);
+    activeAntiAliasing = params.antiAliasing;
+    updateLatency (selected, activeAntiAliasing);
+}
+
+template <typename SampleType>
+typename ClipSatEngine<SampleType>::Oversampling* ClipSatEngine<SampleType>::getOversampler (int stages, int filterType) const
+{
+    if (stages <= 0)
+        return nullptr;
+
+    return oversamplers[filterType * maxOversamplingStages + stages - 1];
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::updateLatency (Oversampling* oversampler, int antiAliasing) noexcept
+{
+    // The antialiased saturator and clipper each add their delay at the processing rate
+    auto latency = 2.0 * AntiderivativeKernels::getDelaySamples (antiAliasing);
+
+    if (oversampler != nullptr)
+        latency = latency / static_cast<double> (oversampler->getOversamplingFactor()) + oversampler->getLatencyInSamples();
+
+    latencySamples = juce::roundToInt (latency);
+}
+
+template <typename SampleType>
+size_t ClipSatEngine<SampleType>::getOversamplingBytes() const noexcept
+{
+    // Stage k of an oversampler keeps twice the samples it is given, which are 2^k
+    // times the block
+    size_t samples = 0;
+
+    for (int filterType = 0; filterType < 2; ++filterType)
+        for (int stages = 1; stages <= maxOversamplingStages && oversamplers.size() > 0; ++stages)
+            samples += static_cast<size_t> (oversamplerBlockSize) * static_cast<size_t> ((2 << stages) - 2);
+
+    return samples * static_cast<size_t> (oversamplerChannels) * sizeof (SampleType);
+}
+
+//==============================================================================
+template <typename SampleType>
+void ClipSatEngine<SampleType>::process (SampleType* const* channels, int numChannels, int numSamples, const Params& params)
+{
+    // prepare() sets up the per-channel state
+    jassert (numChannels <= numPreparedChannels);
+    numChannels = juce::jmin (numChannels, numPreparedChannels);
+
+    // Once per call rather than per sub-block. The stage times run on from one
+    // sub-block to the next and reach the profiler at the end.
+    juce::ScopedNoDenormals noDenormals;
+    stageTimer.start();
+
+    // The chain runs a sub-block at a time, whatever the host's block size. A block
+    // no longer than a sub-block goes straight through, so nothing waits for more
+    // input and no latency is added.
+    if (numSamples <= subBlockLength)
+    {
+        processBlock (channels, numChannels, numSamples, params);
+    }
+    else
+    {
+        SampleType* subBlockChannels[maxNumChannels] = {};
+
+        for (int start = 0; start < numSamples; start += subBlockLength)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                subBlockChannels[channel] = channels[channel] + start;
+
+            processBlock (subBlockChannels, numChannels, juce::jmin (subBlockLength, numSamples - start), params);
+        }
+    }
+
+    stageTimer.stop();
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::processBlock (SampleType* const* channels, int numChannels, int numSamples, const Params& params)
+{
+    // Refers to the caller's channels; nothing is copied or allocated
+    juce::AudioBuffer<SampleType> buffer (channels, numChannels, numSamples);
+
+    // Advance every continuous parameter towards its current value. A settled
+    // parameter returns straight away and leaves its ramp alone, so once nothing
+    // is moving there is no per-sample smoothing work left in the block.
+    auto smooth = [&] (SmoothedParameter<SampleType>& smoother, float target)
+    {
+        smoother.process (static_cast<SampleType> (target), numSamples);
+    };
+
+    smooth (inputGain, params.inputGain);
+    smooth (outputGain, params.outputGain);
+    smooth (threshold, params.thresholdGain);
+    smooth (drive, params.drive);
+    smooth (dryWet, params.dryWet);
+    smooth (chorusRate, params.rate);
+    smooth (chorusDepth, params.depth);
+    smooth (chorusMix, params.mix);
+    smooth (chorusTone, params.tone);
+    smooth (chorusSpread, params.spread);
+    stageTimer.lap (StageProfiler::other);
+
+    // Apply the input gain to the buffer
+    inputGain.applyGain (buffer, numSamples);
+    stageTimer.lap (StageProfiler::inputGain);
+
+    // Push the input to the visualizer before any processing. This only copies
+    // into a preallocated FIFO; the editor drains it on the message thread.
+    if (visualiserFeed != nullptr && numChannels > 0)
+        visualiserFeed->input.push (buffer.getReadPointer (0), numSamples);
+
+    stageTimer.lap (StageProfiler::visualiser);
+
+    auto* oversampler = getOversampler (params.oversamplingStages, params.oversamplingFilter);
+    const int oversamplerIndex = oversampler != nullptr ? oversamplers.indexOf (oversampler) : -1;
+
+    if (oversamplerIndex != activeOversampler || params.antiAliasing != activeAntiAliasing)
+    {
+        if (oversampler != nullptr && oversamplerIndex != activeOversampler)
+            oversampler->reset();
+
+        activeOversampler = oversamplerIndex;
+        activeAntiAliasing = params.antiAliasing;
+        historiesPrimed = false;
+        updateLatency (oversampler, activeAntiAliasing);
+    }
+
+    // Once the input has been silent for the whole tail and the last block came out
+    // silent, nothing is left ringing in the chain, so the block is just cleared
+    const bool inputSilent = isSilent (buffer, numChannels, numSamples);
+    const int tailSamples = juce::roundToInt (getTailLengthSeconds() * sampleRate);
+    stageTimer.lap (StageProfiler::other);
+
+    if (inputSilent && outputSilent && silentSamples >= tailSamples)
+    {
+        buffer.clear (0, numSamples);
+        stageTimer.lap (StageProfiler::other);
+    }
+    else
+    {
+        // With every stage at the host rate, no antiderivative kernels and an approximated
+        // tier, the whole chain runs as one pass per channel group; otherwise stage by stage
+        if (fusedProcessingEnabled && oversampler == nullptr && params.antiAliasing == AntiderivativeKernels::off
+             && params.accuracy != FastMath::Accuracy::exact)
+            processFused (buffer, numChannels, numSamples, params);
+        else
+            processStages (buffer, numChannels, numSamples, params, oversampler, params.oversamplingStages);
+
+        // Apply the output gain to the buffer
+        outputGain.applyGain (buffer, numSamples);
+        stageTimer.lap (StageProfiler::outputGain);
+
+        outputSilent = inputSilent && isSilent (buffer, numChannels, numSamples);
+        stageTimer.lap (StageProfiler::other);
+    }
+
+    if (! inputSilent)
+        silentSamples = 0;
+    else if (silentSamples < tailSamples)
+        silentSamples += numSamples;
+
+    if (visualiserFeed != nullptr)
+    {
+        if (numChannels > 0)
+            visualiserFeed->output.push (buffer.getReadPointer (0), numSamples);
+
+        // Set the threshold value for the visualiser
+        visualiserFeed->threshold.store (params.thresholdGain, std::memory_order_relaxed);
+    }
+
+    stageTimer.lap (StageProfiler::visualiser);
+}
+
+template <typename SampleType>
+bool ClipSatEngine<SampleType>::isSilent (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) const noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (buffer.getMagnitude (channel, 0, numSamples) > static_cast<SampleType> (silenceThreshold))
+            return false;
+
+    return true;
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::processFused (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples, const Params& params)
+{
+    FusedKernels::Configuration configuration;
+    configuration.saturator = params.satOn ? params.saturationMode : FusedKernels::saturatorOff;
+    configuration.accuracy = params.accuracy;
+
+    if (params.clipperOn)
+        configuration.clipper = params.softClipping ? FusedKernels::clipperSoft : FusedKernels::clipperHard;
+
+    if (params.chorusOn)
+        configuration.chorus = FusedKernels::chorusLinear + static_cast<int> (params.chorusInterpolation);
+
+    processGroups (configuration, buffer, numChannels, numSamples, params);
+    stageTimer.lap (StageProfiler::fusedChain);
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::processGroups (const FusedKernels::Configuration& configuration, juce::AudioBuffer<SampleType>& buffer,
+                                               int numChannels, int numSamples, const Params& params)
+{
+    FusedKernels::Context<SampleType> context;
+    context.frames = groupFrames;
+    context.numSamples = numSamples;
+    context.dryWetRamp = dryWet.getRamp();
+    context.driveRamp = drive.getRamp();
+    context.thresholdRamp = threshold.getRamp();
+
+    const SampleType* chorusDelays[maxChorusVoices] = {};
+
+    if (params.chorusOn)
+    {
+        updateChorusVoices (params.chorusVoices);
+        updateChorusDelays (numSamples);
+        updateChorusGains (numChannels, chorusSpread.getCurrentValue());
+
+        for (int voice = 0; voice < numChorusVoices; ++voice)
+            chorusDelays[voice] = chorusScratch.getReadPointer (voice);
+
+        context.delayLine = &chorusDelayLine;
+        context.numChorusVoices = numChorusVoices;
+        context.chorusDelays = chorusDelays;
+        context.chorusMixRamp = chorusMix.getRamp();
+        context.filters = &chorusFilters;
+
+        // The coefficients are worked out once per block, for the tone at its end,
+        // and ramped to across it
+        const auto tone = chorusTone.getCurrentValue();
+
+        if (tone != chorusFilterTone)
+        {
+            chorusFilters.setTarget (getChorusFilter (tone), numSamples);
+            chorusFilterTone = tone;
+        }
+    }
+
+    // Every group runs the same block: interleave it, process it, write it back
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    constexpr auto width = ChannelGroups::getWidth<SampleType>();
+
+    for (int group = 0; group * width < numChannels; ++group)
+    {
+        const auto firstChannel = group * width;
+        ChannelGroups::interleave (channels, firstChannel, numChannels, context.frames, numSamples);
+
+        context.group = group;
+        context.chorusGains = chorusGains + group * maxChorusVoices;
+        FusedKernels::process (configuration, context);
+
+        ChannelGroups::deinterleave (context.frames, channels, firstChannel, numChannels, numSamples);
+    }
+
+    if (params.chorusOn)
+    {
+        chorusDelayLine.advance (numSamples);
+        chorusFilters.advance();
+    }
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::processStages (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples, const Params& params,
+                                               Oversampling* oversampler, int oversamplingStages)
+{
+    // apply chorus if toggled. It runs on the channel groups like the fused path,
+    // and with the saturator off the dry/wet mix against the signal before the
+    // chorus is taken in the same pass; with the chorus off as well that mix is
+    // a no-op.
+    if (params.chorusOn)
+    {
+        FusedKernels::Configuration configuration;
+        configuration.chorus = FusedKernels::chorusLinear + static_cast<int> (params.chorusInterpolation);
+        configuration.saturator = params.satOn ? FusedKernels::saturatorDeferred : FusedKernels::saturatorOff;
+        configuration.accuracy = FastMath::Accuracy::accurate; // Neither stage has an approximated curve
+
+        processGroups (configuration, buffer, numChannels, numSamples, params);
+        stageTimer.lap (StageProfiler::chorus);
+    }
+
+    // The span kernels of the instruction set picked for this CPU
+    const auto& kernels = CpuDispatch::getSpanKernels<SampleType>();
+
+    // The saturator and clipper run at the oversampled rate. The dry side of the
+    // saturator's dry/wet mix is taken inside the same section, so both paths
+    // share the oversampling filters and stay latency-aligned.
+    juce::dsp::AudioBlock<SampleType> block (buffer.getArrayOfWritePointers(), static_cast<size_t> (numChannels), static_cast<size_t> (numSamples));
+    auto oversampledBlock = oversampler != nullptr ? oversampler->processSamplesUp (block) : block;
+    stageTimer.lap (StageProfiler::oversampling);
+    const int oversamplingFactor = 1 << (oversampler != nullptr ? oversamplingStages : 0);
+    const int numOversampledSamples = numSamples * oversamplingFactor;
+
+    // The ramp of a parameter that is still moving, at the oversampled rate, or nullptr
+    // once it has settled. Each host-rate value is held for the samples it covers.
+    auto getOversampledRamp = [&] (const SmoothedParameter<SampleType>& smoother, int slot) -> const SampleType*
+    {
+        if (! smoother.isSmoothing())
+            return nullptr;
+
+        if (oversamplingFactor == 1)
+            return smoother.getRamp();
+
+        auto* ramp = oversampledRamps.getWritePointer (slot);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+            std::fill_n (ramp + sample * oversamplingFactor, oversamplingFactor, smoother.getRamp()[sample]);
+
+        return ramp;
+    };
+
+    const auto* dryWetRamp = params.satOn ? getOversampledRamp (dryWet, 0) : nullptr;
+    const auto* driveRamp = params.satOn ? getOversampledRamp (drive, 1) : nullptr;
+    const auto* thresholdRamp = params.clipperOn ? getOversampledRamp (threshold, 2) : nullptr;
+
+    const auto driveValue = drive.getCurrentValue();
+    const auto thresholdValue = threshold.getCurrentValue();
+
+    const auto antiAliasing = params.antiAliasing;
+    const bool antialiased = antiAliasing != AntiderivativeKernels::off && numOversampledSamples > 0;
+    stageTimer.lap (StageProfiler::other);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelData = oversampledBlock.getChannelPointer (static_cast<size_t> (channel));
+        auto* wetData = wetBuffer.getWritePointer (channel);
+        auto& saturatorHistory = saturatorHistories[channel];
+        auto& clipperHistory = clipperHistories[channel];
+
+        if (antialiased && ! historiesPrimed)
+            saturatorHistory.prime (channelData[0]);
+
+        // Apply the saturation effect based on the selected mode, one channel span at a time
+        if (params.satOn)
+        {
+            if (antialiased)
+            {
+                // The curve reads the dry signal, which is then delayed to match it
+                if (driveRamp != nullptr)
+                    AntiderivativeKernels::processBlock (antiAliasing, params.saturationMode, params.accuracy, channelData, wetData,
+                                                         numOversampledSamples, saturatorHistory, driveRamp);
+                else
+                    AntiderivativeKernels::processBlock (antiAliasing, params.saturationMode, params.accuracy, channelData, wetData,
+                                                         numOversampledSamples, saturatorHistory, driveValue);
+
+                AntiderivativeKernels::alignBlock (antiAliasing, channelData, numOversampledSamples, saturatorHistory);
+            }
+            else
+            {
+                juce::FloatVectorOperations::copy (wetData, channelData, numOversampledSamples);
+
+                if (driveRamp != nullptr)
+                    kernels.saturateRamp (params.saturationMode, params.accuracy, wetData, numOversampledSamples, driveRamp);
+                else
+                    kernels.saturate (params.saturationMode, params.accuracy, wetData, numOversampledSamples, driveValue);
+            }
+
+            // Blend the wet signal with the post-chorus (dry) signal: dry + dryWet * (wet - dry),
+            // with dryWet from its ramp while it is moving
+            kernels.mixDryWet (channelData, wetData, numOversampledSamples, dryWetRamp, dryWet.getCurrentValue());
+        }
+        else if (antialiased)
+        {
+            // Switched off, the stage still delays the signal, so the latency stays put
+            AntiderivativeKernels::alignBlock (antiAliasing, channelData, numOversampledSamples, saturatorHistory);
+        }
+
+        stageTimer.lap (StageProfiler::saturation);
+
+        if (antialiased)
+        {
+            if (! historiesPrimed)
+                clipperHistory.prime (channelData[0]);
+
+            if (params.clipperOn)
+            {
+                // The kernels can't run in place, so the clipper reads a copy of its input
+                juce::FloatVectorOperations::copy (wetData, channelData, numOversampledSamples);
+
+                if (params.softClipping)
+                {
+                    if (thresholdRamp != nullptr)
+                        AntiderivativeKernels::softClipBlock (antiAliasing, params.accuracy, wetData, channelData, numOversampledSamples, clipperHistory, thresholdRamp);
+                    else
+                        AntiderivativeKernels::softClipBlock (antiAliasing, params.accuracy, wetData, channelData, numOversampledSamples, clipperHistory, thresholdValue);
+                }
+                else
+                {
+                    if (thresholdRamp != nullptr)
+                        AntiderivativeKernels::hardClipBlock (antiAliasing, wetData, channelData, numOversampledSamples, clipperHistory, thresholdRamp);
+                    else
+                        AntiderivativeKernels::hardClipBlock (antiAliasing, wetData, channelData, numOversampledSamples, clipperHistory, thresholdValue);
+                }
+
+                clipperHistory.push (wetData, numOversampledSamples);
+            }
+            else
+            {
+                AntiderivativeKernels::alignBlock (antiAliasing, channelData, numOversampledSamples, clipperHistory);
+            }
+        }
+        else if (params.clipperOn)
+        {
+            if (params.softClipping)
+            {
+                if (thresholdRamp != nullptr)
+                    kernels.softClipRamp (params.accuracy, channelData, numOversampledSamples, thresholdRamp);
+                else
+                    kernels.softClip (params.accuracy, channelData, numOversampledSamples, thresholdValue);
+            }
+            else
+            {
+                if (thresholdRamp != nullptr)
+                    kernels.hardClipRamp (channelData, numOversampledSamples, thresholdRamp);
+                else
+                    kernels.hardClip (channelData, numOversampledSamples, thresholdValue);
+            }
+        }
+
+        stageTimer.lap (StageProfiler::clipping);
+    }
+
+    if (antialiased)
+        historiesPrimed = true;
+
+    if (oversampler != nullptr)
+        oversampler->processSamplesDown (block);
+
+    stageTimer.lap (StageProfiler::oversampling);
+}
+
+//==============================================================================
+template <typename SampleType>
+typename BiquadBank<SampleType>::Coefficients ClipSatEngine<SampleType>::getChorusFilter (SampleType tone) const noexcept
+{
+    const auto maxTone = static_cast<SampleType> (maxToneNyquistFraction * 0.5 * sampleRate);
+    return BiquadBank<SampleType>::makeLowPass (sampleRate, juce::jmin (tone, maxTone));
+}
+
+template <typename SampleType>
+float ClipSatEngine<SampleType>::getChorusDelayScale (float depth) const noexcept
+{
+    return depth * 0.02f * static_cast<float> (sampleRate); // 20ms max delay at full depth
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::updateChorusVoices (int numVoices)
+{
+    numVoices = juce::jlimit (1, maxChorusVoices, numVoices);
+
+    if (numVoices == numChorusVoices)
+        return;
+
+    // Voices that join take their place around the cycle from the first voice's
+    // current phase, so the ones already running carry on undisturbed
+    const auto phase = std::atan2 (chorusLfos[0].getSin(), chorusLfos[0].getCos());
+    const auto delayScale = getChorusDelayScale (static_cast<float> (chorusDepth.getCurrentValue()));
+
+    for (int voice = numChorusVoices; voice < numVoices; ++voice)
+    {
+        chorusLfos[voice].reset (phase + juce::MathConstants<float>::twoPi * static_cast<float> (voice) / static_cast<float> (numVoices));
+        chorusDelayFrom[voice] = chorusDelayTo[voice] = (1.0f + chorusLfos[voice].getSin()) * 0.5f * delayScale;
+    }
+
+    numChorusVoices = numVoices;
+    chorusGainsChannels = 0; // The level compensation and the pan positions have changed
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::updateChorusDelays (int numSamples)
+{
+    // Each voice runs a little faster than the one before, up to 1.2 times the rate
+    const auto numVoices = numChorusVoices;
+
+    auto setRate = [&] (float rate)
+    {
+        for (int voice = 0; voice < numVoices; ++voice)
+        {
+            const auto detune = numVoices > 1 ? 0.2f * static_cast<float> (voice) / static_cast<float> (numVoices - 1) : 0.0f;
+            chorusLfos[voice].setFrequency (rate * (1.0f + detune), sampleRate, chorusLfoStep);
+        }
+    };
+
+    // While rate or depth are moving, they are picked up from their ramps at every LFO step
+    const bool modulationSmoothing = chorusRate.isSmoothing() || chorusDepth.isSmoothing();
+    float delayScale = getChorusDelayScale (static_cast<float> (chorusDepth.getCurrentValue()));
+
+    if (! modulationSmoothing)
+        setRate (static_cast<float> (chorusRate.getCurrentValue()));
+
+    // Delay times for the block, one channel per voice, shared by every audio channel.
+    // The LFOs are only stepped every chorusLfoStep samples, and the delay is ramped
+    // linearly in between, one voice at a time across each stretch between steps.
+    for (int sample = 0; sample < numSamples;)
+    {
+        const auto stretch = juce::jmin (numSamples - sample, chorusLfoStep - chorusLfoCounter);
+
+        for (int voice = 0; voice < numVoices; ++voice)
+        {
+            auto* delays = chorusScratch.getWritePointer (voice, sample);
+            const auto from = chorusDelayFrom[voice], distance = chorusDelayTo[voice] - chorusDelayFrom[voice];
+
+            for (int i = 0; i < stretch; ++i)
+                delays[i] = from + static_cast<float> (chorusLfoCounter + i) * (1.0f / chorusLfoStep) * distance;
+        }
+
+        sample += stretch;
+        chorusLfoCounter += stretch;
+
+        if (chorusLfoCounter == chorusLfoStep)
+        {
+            chorusLfoCounter = 0;
+
+            if (modulationSmoothing)
+            {
+                setRate (static_cast<float> (chorusRate.getRamp()[sample - 1]));
+                delayScale = getChorusDelayScale (static_cast<float> (chorusDepth.getRamp()[sample - 1]));
+            }
+
+            for (int voice = 0; voice < numVoices; ++voice)
+            {
+                chorusLfos[voice].step();
+                chorusDelayFrom[voice] = chorusDelayTo[voice];
+                chorusDelayTo[voice] = (1.0f + chorusLfos[voice].getSin()) * 0.5f * delayScale;
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void ClipSatEngine<SampleType>::updateChorusGains (int numChannels, SampleType spread)
+{
+    if (numChannels == chorusGainsChannels && spread == chorusGainsSpread)
+        return;
+
+    chorusGainsChannels = numChannels;
+    chorusGainsSpread = spread;
+
+    // However many voices there are, they come out at the level the original two had
+    constexpr auto width = ChannelGroups::getWidth<SampleType>();
+    const auto level = (1.0f + feedbackAmount) * 2.0 / numChorusVoices;
+
+    for (int voice = 0; voice < numChorusVoices; ++voice)
+    {
+        // The voices are spaced evenly across each stereo pair, first to last from left
+        // to right, with an equal-power pan that is unity in the centre. Every other
+        // channel hears every voice in the centre.
+        const auto position = numChorusVoices > 1 ? spread * (2.0 * voice / (numChorusVoices - 1) - 1.0) : 0.0;
+        const auto angle = (position + 1.0) * juce::MathConstants<double>::pi * 0.25;
+        const auto left = static_cast<SampleType> (level * juce::MathConstants<double>::sqrt2 * std::cos (angle));
+        const auto right = static_cast<SampleType> (level * juce::MathConstants<double>::sqrt2 * std::sin (angle));
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            auto gains = Register::expand (static_cast<SampleType> (level));
+
+            for (int lane = 0; lane < width && group * width + lane < numChannels; ++lane)
+            {
+                const auto side = chorusPanSides[group * width + lane];
+
+                if (side != PanSide::centre)
+                    gains.set (static_cast<size_t> (lane), side == PanSide::left ? left : right);
+            }
+
+            chorusGains[group * maxChorusVoices + voice] = gains;
+        }
+    }
+}
+
+//==============================================================================
+template class ClipSatEngine<float>;
+template class ClipSatEngine<double>;
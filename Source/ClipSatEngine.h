@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    ClipSatEngine.h
+
+    The whole signal chain (input gain, chorus, saturator, clipper, the
+    oversampling around them and output gain) with everything it keeps
+    between blocks, behind a plain buffer API. It only needs juce_core,
+    juce_audio_basics and juce_dsp, so it runs without the plugin wrapper:
+    ClipSatAudioProcessor owns one per processing precision and hands it a
+    ParameterSnapshot every block, and the Engine project builds it on its
+    own as a static library for other hosts.
+
+    Any number of discrete channels up to maxNumChannels is supported. The
+    host-rate part of the chain runs on channel groups as wide as a SIMD
+    register (see ChannelGroups.h), so a multichannel bed costs far less
+    than the same channels split across stereo instances.
+
+    Whatever block size the host uses, the chain runs over at most
+    subBlockSize samples at a time, so its scratch buffers stay in cache,
+    and the work it does once per block (advancing the smoothers, working
+    out the chorus filter, switching the oversampling and detecting
+    silence) happens at least every subBlockSize samples. Smaller blocks
+    go straight through, without waiting for more input.
+
+    Once the input has been silent for longer than the tail and the output
+    has died away, process() only clears the buffer until sound comes back.
+
+    Everything the chain keeps between blocks is allocated from one DspArena
+    when it is prepared: the processor's, shared with its bypass fader, or
+    the engine's own when it runs on its own. The oversamplers are the
+    exception; juce::dsp::Oversampling allocates its own buffers.
+
+    The saturator and clipper can be antialiased with antiderivatives (see
+    AntiderivativeKernels.h) instead of, or as well as, oversampling. That
+    adds a fixed delay per stage, which the latency includes; a stage that
+    is switched off is delayed just the same, so the latency only follows
+    the antiAliasing and oversampling choices.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AntiderivativeKernels.h"
+#include "BiquadBank.h"
+#include "ChannelGroups.h"
+#include "ChorusDelayLine.h"
+#include "DspArena.h"
+#include "FastMath.h"
+#include "FusedKernels.h"
+#include "SmoothedParameter.h"
+#include "ParameterSnapshot.h"
+#include "StageProfiler.h"
+#include "VisualiserFeed.h"
+
+template <typename SampleType>
+class ClipSatEngine
+{
+public:
+    using Params = ParameterSnapshot;
+
+    ClipSatEngine();
+    ~ClipSatEngine();
+
+    //==============================================================================
+    /** Allocates everything for numChannels channels, with every continuous
+        parameter settled on its value in params, from an arena of the engine's
+        own. Buffers are sized for one sub-block: subBlockSize samples, or
+        maximumBlockSize if that is smaller.
+
+        layout says which channels are stereo pairs (L and R, Ls and Rs and so
+        on), the only ones the chorus spread pans across; the centre, the LFE
+        and discrete channels hear every voice in the middle. Without one, or
+        with one of a different size, the layout JUCE would guess for
+        numChannels is used.
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels, const Params& params,
+                  const juce::AudioChannelSet& layout = {});
+
+    /** The same, allocating from arena as part of DspArena::layOut(), for a caller
+        that keeps other state in the same arena. The arena must outlive the
+        engine's use of it, up to release() or the next prepare().
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels, const Params& params, DspArena& arena,
+                  const juce::AudioChannelSet& layout = {});
+
+    /** Frees everything prepare() allocated, and forgets the arena. */
+    void release();
+
+    /** Clears the chorus, filter and oversampling state, as if the input had
+        been silent for longer than the tail. Doesn't allocate.
+    */
+    void reset();
+
+    /** Processes the first numSamples of each channel in place, a sub-block at
+        a time. numChannels mustn't be more than prepare() was given. Nothing is
+        allocated, whatever numSamples is.
+    */
+    void process (SampleType* const* channels, int numChannels, int numSamples, const Params& params);
+
+    //==============================================================================
+    /** The delay through the oversampling and anti-aliasing selected by the last
+        prepare() or process(), in samples. Hosts need this to line the output up.
+    */
+    int getLatencySamples() const noexcept    { return latencySamples; }
+
+    /** The most latency any oversampling and anti-aliasing selection adds, in samples. */
+    int getMaxLatencySamples() const noexcept    { return maxLatencySamples; }
+
+    /** How long the output keeps going after the input stops: the latency, the
+        longest chorus delay and the time its filters take to decay.
+    */
+    double getTailLengthSeconds() const noexcept
+    {
+        return maxChorusDelaySeconds + filterDecaySeconds + latencySamples / sampleRate;
+    }
+
+    /** Lets process() use the fused per-configuration kernels whenever the
+        configuration allows it. Only the benchmarks turn this off, to time the
+        stage-by-stage path on its own.
+    */
+    void setFusedProcessingEnabled (bool shouldBeEnabled) noexcept    { fusedProcessingEnabled = shouldBeEnabled; }
+
+    /** Where to push the first channel before and after processing, for the
+        editor's visualiser. nullptr, the default, pushes nothing.
+    */
+    void setVisualiserFeed (VisualiserFeed* feedToUse) noexcept    { visualiserFeed = feedToUse; }
+
+    /** Where to add the time each stage of process() takes, while its stage timing
+        is on, once per call whatever the number of sub-blocks. nullptr, the
+        default, times nothing.
+    */
+    void setProfiler (StageProfiler* profilerToUse) noexcept    { stageTimer = StageProfiler::Timer (profilerToUse); }
+
+    /** The engine's own arena: empty unless prepare() was called without one. */
+    const DspArena& getOwnArena() const noexcept    { return ownArena; }
+
+    /** Roughly what the prepared oversamplers hold, in bytes. juce::dsp::Oversampling
+        doesn't say, so this counts the buffer each stage keeps and leaves out the
+        filters, which are a small fraction of it.
+    */
+    size_t getOversamplingBytes() const noexcept;
+
+    //==============================================================================
+    // The widest layout prepare() accepts
+    static constexpr int maxNumChannels = 16;
+
+    // The most samples the chain runs over at once
+    static constexpr int subBlockSize = 64;
+
+    // Smoothing time constants for the continuous parameters
+    static constexpr double levelSmoothingMs = 20.0;      // Gains, threshold, drive, dry/wet and chorus mix
+    static constexpr double modulationSmoothingMs = 50.0; // Chorus rate, depth, tone and spread
+
+    // Chorus: up to eight voices read from one delay line per channel group. The
+    // depth parameter tops out at 0.5, so the longest delay is 0.5 * 20ms.
+    static constexpr int maxChorusVoices = 8;
+    static constexpr int chorusLfoStep = 32; // Samples between LFO updates
+    static constexpr double maxChorusDelaySeconds = 0.5 * 0.02;
+
+    // The chorus tone is a low-pass cutoff in Hz, kept clear of Nyquist
+    static constexpr double maxToneNyquistFraction = 0.9;
+
+    // Oversampling around the saturator and clipper: 2x, 4x or 8x, IIR or FIR half-band
+    static constexpr int maxOversamplingStages = 3;
+
+    // Silence detection: below -100 dBFS counts as silent, and the chorus low-pass
+    // filters and the oversampling filters' ringing are below that well within 5ms
+    static constexpr double silenceThreshold = 1.0e-5;
+    static constexpr double filterDecaySeconds = 0.005;
+
+private:
+    //==============================================================================
+    using Oversampling = juce::dsp::Oversampling<SampleType>;
+    using Register = ChannelGroups::Register<SampleType>;
+
+    void processBlock (SampleType* const* channels, int numChannels, int numSamples, const Params& params);
+
+    void prepareOversamplers (int samplesPerBlock, const Params& params);
+    Oversampling* getOversampler (int stages, int filterType) const;
+    void updateLatency (Oversampling* oversampler, int antiAliasing) noexcept;
+
+    bool isSilent (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) const noexcept;
+
+    void processFused (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples, const Params& params);
+    void processStages (juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples, const Params& params,
+                        Oversampling* oversampler, int oversamplingStages);
+
+    void processGroups (const FusedKernels::Configuration& configuration, juce::AudioBuffer<SampleType>& buffer,
+                        int numChannels, int numSamples, const Params& params);
+    float getChorusDelayScale (float depth) const noexcept;
+    void updateChorusVoices (int numVoices);
+    void updateChorusDelays (int numSamples);
+    void updateChorusGains (int numChannels, SampleType spread);
+    typename BiquadBank<SampleType>::Coefficients getChorusFilter (SampleType tone) const noexcept;
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+    int numPreparedChannels = 0;
+    int numGroups = 0;
+    int subBlockLength = 0; // subBlockSize, or the host's block size if that is smaller
+
+    // Only allocated from when prepare() isn't given an arena
+    DspArena ownArena;
+
+    ChorusDelayLine<SampleType> chorusDelayLine;
+    QuadratureOscillator chorusLfos[maxChorusVoices];
+    float chorusDelayFrom[maxChorusVoices] = {}, chorusDelayTo[maxChorusVoices] = {};
+    int chorusLfoCounter = 0;
+    int numChorusVoices = 0;
+    juce::AudioBuffer<SampleType> chorusScratch; // Per-voice delay times, referring to the arena, as are the other buffers
+
+    float feedbackAmount = 0.1f;
+
+    // Each voice's gain in every lane of every group: its pan across a stereo pair,
+    // the tap gain and the level compensation for the voice count
+    Register* chorusGains = nullptr;
+    int chorusGainsChannels = 0;
+    SampleType chorusGainsSpread = -1;
+
+    // Which side of a stereo pair each channel is on, from prepare()'s layout
+    enum class PanSide : char { centre, left, right };
+    PanSide chorusPanSides[maxNumChannels] = {};
+
+    BiquadBank<SampleType> chorusFilters; // A low-pass filter on the voices' mix, per channel group
+    SampleType chorusFilterTone = 0;      // The tone the filters were last set to
+
+    Register* groupFrames = nullptr; // One channel group at a time, interleaved
+
+    juce::AudioBuffer<SampleType> wetBuffer; // Saturator wet path, one channel span at a time
+
+    // The continuous parameters. Each one only fills its ramp while it is moving.
+    SmoothedParameter<SampleType> inputGain, outputGain, threshold, drive, dryWet;
+    SmoothedParameter<SampleType> chorusRate, chorusDepth, chorusMix, chorusTone, chorusSpread;
+
+    // dry/wet, drive and threshold ramps held for each oversampled sample
+    juce::AudioBuffer<SampleType> oversampledRamps;
+
+    juce::OwnedArray<Oversampling> oversamplers;
+    int oversamplerBlockSize = 0, oversamplerChannels = 0;
+    int activeOversampler = -1;
+    int latencySamples = 0, maxLatencySamples = 0;
+
+    // Each channel's last two inputs to the saturator and to the clipper, for the
+    // antiderivative kernels. They are primed from the next block's first sample
+    // whenever the anti-aliasing or oversampling selection changes.
+    AntiderivativeKernels::History<SampleType>* saturatorHistories = nullptr;
+    AntiderivativeKernels::History<SampleType>* clipperHistories = nullptr;
+    int activeAntiAliasing = AntiderivativeKernels::off;
+    bool historiesPrimed = false;
+
+    // Silent input samples in a row, counted up to the tail length, and whether
+    // the last block processed came out silent
+    int silentSamples = 0;
+    bool outputSilent = false;
+
+    bool fusedProcessingEnabled = true;
+    VisualiserFeed* visualiserFeed = nullptr;
+    StageProfiler::Timer stageTimer;
+
+    JUCE_DECLARE_NON_COPYABLE (ClipSatEngine)
+};
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    CompactState.h
+
+    The plugin's saved state as a small versioned binary block, written
+    straight from the parameters and read straight back into them, without
+    building a ValueTree or parsing XML. Restoring a session with hundreds
+    of instances spends its time here, so a load only touches parameters
+    whose value actually changes.
+
+    Layout, little-endian:
+
+        uint32  magic ("XLCS")
+        uint16  version
+        uint16  number of entries
+        entries, each:
+            uint32  FNV-1a hash of the parameter ID
+            float   the value, in the parameter's own range
+
+    Entries are matched to parameters by hash, so parameters can be added,
+    removed or reordered without a new version: unknown entries are skipped,
+    and parameters with no entry keep their value. A later version may
+    append fields after the entries, which this reader ignores. Anything
+    without the magic number is left for the processor's XML fallback.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <vector>
+
+class CompactState
+{
+public:
+    static constexpr juce::uint32 magic = 0x53434c58; // "XLCS" in file order
+    static constexpr int currentVersion = 1;
+    static constexpr int headerSize = 8, entrySize = 8;
+
+    /** Resolves every parameter of state once, so reading and writing never
+        look one up by ID.
+    */
+    explicit CompactState (juce::AudioProcessorValueTreeState& state)
+    {
+        for (auto* parameter : state.processor.getParameters())
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            {
+                const auto id = ranged->getParameterID();
+                entries.push_back ({ hash (id), ranged, state.getRawParameterValue (id) });
+            }
+        }
+
+        std::sort (entries.begin(), entries.end(), [] (const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+        // Two IDs with the same hash couldn't be told apart in a saved state
+        jassert (std::adjacent_find (entries.begin(), entries.end(), [] (const Entry& a, const Entry& b) { return a.hash == b.hash; }) == entries.end());
+    }
+
+    /** Replaces destData with the current value of every parameter. */
+    void write (juce::MemoryBlock& destData) const
+    {
+        destData.reset();
+        destData.ensureSize (static_cast<size_t> (headerSize + entrySize * static_cast<int> (entries.size())));
+
+        juce::MemoryOutputStream stream (destData, false);
+        stream.writeInt (static_cast<int> (magic));
+        stream.writeShort (static_cast<short> (currentVersion));
+        stream.writeShort (static_cast<short> (entries.size()));
+
+        for (auto& entry : entries)
+        {
+            stream.writeInt (static_cast<int> (entry.hash));
+            stream.writeFloat (entry.value->load (std::memory_order_relaxed));
+        }
+    }
+
+    /** Sets every parameter data has a value for, and returns true, if data is in
+        this format. Returns false, changing nothing, if it isn't.
+    */
+    bool read (const void* data, int sizeInBytes) const
+    {
+        if (! isCompactState (data, sizeInBytes))
+            return false;
+
+        juce::MemoryInputStream stream (data, static_cast<size_t> (sizeInBytes), false);
+        stream.skipNextBytes (6);
+
+        const auto numEntries = static_cast<int> (static_cast<juce::uint16> (stream.readShort()));
+
+        if (sizeInBytes < headerSize + entrySize * numEntries)
+            return false;
+
+        for (int i = 0; i < numEntries; ++i)
+        {
+            const auto entryHash = static_cast<juce::uint32> (stream.readInt());
+            const auto value = stream.readFloat();
+
+            const auto found = std::lower_bound (entries.begin(), entries.end(), entryHash,
+                                                 [] (const Entry& entry, juce::uint32 h) { return entry.hash < h; });
+
+            if (found == entries.end() || found->hash != entryHash)
+                continue;
+
+            // A parameter already at the saved value isn't touched, so nothing is notified
+            const auto normalised = found->parameter->convertTo0to1 (value);
+
+            if (normalised != found->parameter->getValue())
+                found->parameter->setValueNotifyingHost (normalised);
+        }
+
+        return true;
+    }
+
+    /** Whether data starts with this format's magic number and a version it can read. */
+    static bool isCompactState (const void* data, int sizeInBytes) noexcept
+    {
+        if (data == nullptr || sizeInBytes < headerSize)
+            return false;
+
+        const auto* bytes = static_cast<const juce::uint8*> (data);
+        return juce::ByteOrder::littleEndianInt (bytes) == magic
+            && juce::ByteOrder::littleEndianShort (bytes + 4) >= 1;
+    }
+
+private:
+    struct Entry
+    {
+        juce::uint32 hash;
+        juce::RangedAudioParameter* parameter;
+        std::atomic<float>* value;
+    };
+
+    static juce::uint32 hash (const juce::String& parameterID) noexcept
+    {
+        juce::uint32 h = 2166136261u;
+
+        for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+            h = (h ^ static_cast<juce::uint8> (*c)) * 16777619u;
+
+        return h;
+    }
+
+    std::vector<Entry> entries; // Sorted by hash
+
+    JUCE_DECLARE_NON_COPYABLE (CompactState)
+};
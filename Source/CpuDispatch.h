@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    CpuDispatch.h
+
+    Picks the build of the span kernels (see SpanKernels.h) for the CPU the
+    plug-in is running on, once per process: AVX-512 where the CPU has
+    AVX-512F, then AVX2, then the SSE2 baseline that every x86-64 CPU has.
+    On ARM the baseline is NEON and there is nothing to pick.
+
+    The choice can be forced, to compare the builds or to rule one out when
+    chasing a problem on a user's machine: set CLIPSAT_CPU_VARIANT to sse2,
+    avx2 or avx512 before the plug-in loads, or call force(). A variant the
+    CPU can't run is refused and the current one is kept. Every build gives
+    the same output, so switching while audio runs is harmless; the engine
+    picks the table up at the start of each block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpanKernels.h"
+#include <atomic>
+
+namespace CpuDispatch
+{
+    enum Variant
+    {
+        sse2 = 0,
+        avx2,
+        avx512,
+        neon,
+        numVariants
+    };
+
+    inline const char* getVariantName (int variant) noexcept
+    {
+        static const char* const names[] = { "sse2", "avx2", "avx512", "neon" };
+        return juce::isPositiveAndBelow (variant, static_cast<int> (numVariants)) ? names[variant] : "";
+    }
+
+    /** The kernels built for variant, or nullptr if this platform or compiler has none. */
+    inline const SpanKernels::Build* getBuild (Variant variant) noexcept
+    {
+        switch (variant)
+        {
+           #if JUCE_ARM
+            case neon:   return &SpanKernels::getBaselineBuild();
+           #else
+            case sse2:   return &SpanKernels::getBaselineBuild();
+            case avx2:   return SpanKernels::getAVX2Build();
+            case avx512: return SpanKernels::getAVX512Build();
+           #endif
+            default:     return nullptr;
+        }
+    }
+
+    /** True if variant was built and this CPU can run it. */
+    inline bool isSupported (Variant variant) noexcept
+    {
+        if (getBuild (variant) == nullptr)
+            return false;
+
+        switch (variant)
+        {
+            case sse2:   return juce::SystemStats::hasSSE2();
+            case avx2:   return juce::SystemStats::hasAVX() && juce::SystemStats::hasAVX2();
+            case avx512: return juce::SystemStats::hasAVX512F();
+            case neon:   return true;
+            default:     return false;
+        }
+    }
+
+    /** The fastest variant this CPU supports. */
+    inline Variant getBestVariant() noexcept
+    {
+        static const Variant best = []
+        {
+            for (auto variant : { avx512, avx2, sse2, neon })
+                if (isSupported (variant))
+                    return variant;
+
+            jassertfalse; // The baseline is always supported
+            return sse2;
+        }();
+
+        return best;
+    }
+
+    /** The variant named name ("sse2", "avx2", ...), or numVariants if there isn't one. */
+    inline Variant findVariant (const juce::String& name)
+    {
+        for (int variant = 0; variant < numVariants; ++variant)
+            if (name.trim().equalsIgnoreCase (getVariantName (variant)))
+                return static_cast<Variant> (variant);
+
+        return numVariants;
+    }
+
+    namespace detail
+    {
+        // Read from the environment the first time, which ClipSatEngine::prepare makes
+        // sure isn't on the audio thread
+        inline std::atomic<int>& getActiveVariant()
+        {
+            static std::atomic<int> active { [] () -> int
+            {
+                const auto forced = findVariant (juce::SystemStats::getEnvironmentVariable ("CLIPSAT_CPU_VARIANT", {}));
+                return forced != numVariants && isSupported (forced) ? forced : getBestVariant();
+            }() };
+
+            return active;
+        }
+    }
+
+    /** The variant the engine's span kernels run on. */
+    inline Variant getActiveVariant() noexcept
+    {
+        return static_cast<Variant> (detail::getActiveVariant().load (std::memory_order_relaxed));
+    }
+
+    /** Makes variant the active one, for every instance in the process. Returns
+        false, changing nothing, if this CPU can't run it.
+    */
+    inline bool force (Variant variant) noexcept
+    {
+        if (! isSupported (variant))
+            return false;
+
+        detail::getActiveVariant().store (variant, std::memory_order_relaxed);
+        return true;
+    }
+
+    inline bool force (const juce::String& name)    { return force (findVariant (name)); }
+
+    /** The active variant's kernels. */
+    template <typename SampleType>
+    const SpanKernels::Table<SampleType>& getSpanKernels() noexcept
+    {
+        return getBuild (getActiveVariant())->template get<SampleType>();
+    }
+}
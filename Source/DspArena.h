@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    DspArena.h
+
+    One block of memory for everything the audio thread keeps between
+    blocks: the chorus delay lines, filter states, parameter ramps, scratch
+    buffers and the bypass fader's dry signal. prepareToPlay sizes it and
+    carves it up, and nothing on the audio thread allocates after that.
+
+    Laying it out takes two passes over the same code. The first only
+    measures: every allocate() returns nullptr and adds up what was asked
+    for. The block is then allocated once, at the total, and the second pass
+    hands out the real pointers. Code that allocates from an arena mustn't
+    touch the memory while isMeasuring() is true.
+
+    Every allocation starts on a cache line and comes back value-initialised,
+    so state starts at zero. Per-channel state is planar: each channel of a
+    buffer is its own run of samples, and SIMD state holds one channel per
+    lane (see ChannelGroups.h), so no two channels share a cache line.
+
+    The arena also counts the bytes each subsystem takes, for the memory
+    footprint report.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <vector>
+
+class DspArena
+{
+public:
+    enum Subsystem
+    {
+        chorus = 0,     // Delay lines, allpass states, voice delay times and gains
+        filters,        // The chorus low-pass
+        smoothing,      // Parameter ramps
+        scratch,        // Interleaved groups, the saturator's wet path, oversampled ramps
+        antiAliasing,   // The antiderivative kernels' histories
+        bypass,         // The latency-compensated dry signal and the fade buffer
+        numSubsystems
+    };
+
+    static const char* getSubsystemName (int subsystem) noexcept
+    {
+        static const char* const names[] = { "Chorus", "Chorus filters", "Parameter smoothing", "Scratch buffers",
+                                             "Anti-aliasing", "Bypass fader" };
+        return juce::isPositiveAndBelow (subsystem, static_cast<int> (numSubsystems)) ? names[subsystem] : "";
+    }
+
+    static constexpr size_t alignment = 64;
+
+    DspArena() = default;
+
+    //==============================================================================
+    /** Runs allocateAll (DspArena&) once to measure and once to allocate, and
+        reallocates the block in between if the size has changed. Everything
+        previously handed out is invalid afterwards.
+    */
+    template <typename AllocateAll>
+    void layOut (AllocateAll&& allocateAll)
+    {
+        begin (true);
+        allocateAll (*this);
+
+        if (used != capacity)
+        {
+            storage.reset (used > 0 ? new char[used + alignment] : nullptr);
+            capacity = used;
+        }
+
+        begin (false);
+        allocateAll (*this);
+
+        jassert (used == capacity); // Both passes have to ask for the same things
+    }
+
+    /** Frees the block. Everything handed out is invalid afterwards. */
+    void release()
+    {
+        storage.reset();
+        capacity = used = 0;
+        std::fill (std::begin (subsystemBytes), std::end (subsystemBytes), static_cast<size_t> (0));
+    }
+
+    /** True in layOut()'s first pass, when allocate() only counts. */
+    bool isMeasuring() const noexcept    { return measuring; }
+
+    /** count value-initialised objects of type T, starting on a cache line, or
+        nullptr while measuring.
+    */
+    template <typename T>
+    T* allocate (Subsystem subsystem, int count)
+    {
+        static_assert (alignof (T) <= alignment, "The arena can't align this type");
+
+        const auto bytes = roundUp (static_cast<size_t> (juce::jmax (0, count)) * sizeof (T));
+        const auto offset = used;
+
+        used += bytes;
+        subsystemBytes[subsystem] += bytes;
+
+        if (measuring || bytes == 0)
+            return nullptr;
+
+        jassert (used <= capacity);
+        auto* data = reinterpret_cast<T*> (getBase() + offset);
+        std::uninitialized_value_construct_n (data, static_cast<size_t> (count));
+        return data;
+    }
+
+    //==============================================================================
+    /** The size of the block, in bytes. */
+    size_t getCapacity() const noexcept    { return capacity; }
+
+    /** What subsystem took in the last layOut(), including its alignment padding. */
+    size_t getBytes (Subsystem subsystem) const noexcept    { return subsystemBytes[subsystem]; }
+
+private:
+    static size_t roundUp (size_t bytes) noexcept    { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+    char* getBase() const noexcept
+    {
+        const auto address = reinterpret_cast<juce::pointer_sized_uint> (storage.get());
+        return storage.get() + (roundUp (address) - address);
+    }
+
+    void begin (bool measure) noexcept
+    {
+        measuring = measure;
+        used = 0;
+        std::fill (std::begin (subsystemBytes), std::end (subsystemBytes), static_cast<size_t> (0));
+    }
+
+    std::unique_ptr<char[]> storage;
+    size_t capacity = 0, used = 0;
+    size_t subsystemBytes[numSubsystems] = {};
+    bool measuring = false;
+
+    JUCE_DECLARE_NON_COPYABLE (DspArena)
+};
+
+//==============================================================================
+/** An instance's memory, subsystem by subsystem, for budgeting sessions with
+    many instances. Entries outside the arena are either allocated elsewhere on
+    purpose or owned by JUCE, where the size is an estimate.
+*/
+struct MemoryFootprint
+{
+    struct Entry
+    {
+        juce::String name;
+        size_t bytes;
+        bool inArena;
+    };
+
+    std::vector<Entry> entries;
+
+    void add (const juce::String& name, size_t bytes, bool inArena)    { entries.push_back ({ name, bytes, inArena }); }
+
+    /** Adds every subsystem of arena. */
+    void addArena (const DspArena& arena)
+    {
+        for (int subsystem = 0; subsystem < DspArena::numSubsystems; ++subsystem)
+            add (DspArena::getSubsystemName (subsystem), arena.getBytes (static_cast<DspArena::Subsystem> (subsystem)), true);
+    }
+
+    size_t getTotalBytes() const noexcept
+    {
+        size_t total = 0;
+
+        for (auto& entry : entries)
+            total += entry.bytes;
+
+        return total;
+    }
+
+    size_t getArenaBytes() const noexcept
+    {
+        size_t total = 0;
+
+        for (auto& entry : entries)
+            if (entry.inArena)
+                total += entry.bytes;
+
+        return total;
+    }
+
+    /** A plain text table, in kilobytes. */
+    juce::String toString() const
+    {
+        juce::String report;
+
+        auto addLine = [&] (const juce::String& name, size_t bytes, const char* where)
+        {
+            report << name.paddedRight (' ', 28) << juce::String (static_cast<double> (bytes) / 1024.0, 1).paddedLeft (' ', 10)
+                   << " KB  " << where << "\n";
+        };
+
+        for (auto& entry : entries)
+            addLine (entry.name, entry.bytes, entry.inArena ? "arena" : "");
+
+        addLine ("Arena", getArenaBytes(), "");
+        addLine ("Total", getTotalBytes(), "");
+        return report;
+    }
+};
@@ -0,0 +1,295 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Approximations for the transcendental functions used by the saturator and
+    the soft clipper, in three accuracy tiers:
+
+      - exact:    libm, evaluated one sample at a time (mastering)
+      - accurate: higher-order minimax polynomials, SIMD friendly
+      - fast:     lower-order minimax polynomials, SIMD friendly (tracking)
+
+    Every approximation is written once as a template and works on float,
+    double and juce::dsp::SIMDRegister of either. The coefficients are
+    fitted for float, so in double the error bounds stay those of the
+    float fit. Maximum errors of the polynomials on their reduced range:
+
+                        accurate        fast
+      sin               3.4e-9 abs      6.8e-5 abs    (on [-pi/2, pi/2])
+      exp               7.5e-8 rel      7.5e-5 rel    (2^f on [0, 1))
+
+    Arguments are range reduced first, so these hold over the whole input
+    range plus the float rounding of the reduction itself, which brings the
+    accurate tier to about 2e-6 over |x| <= 20. The benchmark in Benchmarks/
+    reports the measured errors against libm.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <type_traits>
+
+namespace FastMath
+{
+    enum class Accuracy
+    {
+        exact = 0,
+        accurate,
+        fast
+    };
+
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    /** The sample type of a scalar or of a SIMDRegister. */
+    template <typename T> struct ScalarType                                { using type = T; };
+    template <typename T> struct ScalarType<juce::dsp::SIMDRegister<T>>   { using type = T; };
+    template <typename T> using ScalarOf = typename ScalarType<T>::type;
+
+    template <typename T> using EnableIfScalar = std::enable_if_t<std::is_floating_point_v<T>, T>;
+
+    //==============================================================================
+    template <typename T> inline EnableIfScalar<T> truncate (T x) noexcept   { return std::trunc (x); }
+    template <typename T> inline EnableIfScalar<T> abs (T x) noexcept        { return std::abs (x); }
+    template <typename T> inline EnableIfScalar<T> floor (T x) noexcept      { return std::floor (x); }
+
+    template <typename T>
+    inline juce::dsp::SIMDRegister<T> truncate (juce::dsp::SIMDRegister<T> x) noexcept   { return juce::dsp::SIMDRegister<T>::truncate (x); }
+
+    template <typename T>
+    inline juce::dsp::SIMDRegister<T> abs (juce::dsp::SIMDRegister<T> x) noexcept        { return juce::dsp::SIMDRegister<T>::abs (x); }
+
+    template <typename T>
+    inline juce::dsp::SIMDRegister<T> floor (juce::dsp::SIMDRegister<T> x) noexcept
+    {
+        using Register = juce::dsp::SIMDRegister<T>;
+        auto t = Register::truncate (x);
+        return t - (Register::expand (T (1)) & Register::lessThan (x, t));
+    }
+
+    template <typename T>
+    inline EnableIfScalar<T> clamp (T x, T lo, T hi) noexcept
+    {
+        return std::max (lo, std::min (hi, x));
+    }
+
+    template <typename T>
+    inline juce::dsp::SIMDRegister<T> clamp (juce::dsp::SIMDRegister<T> x, T lo, T hi) noexcept
+    {
+        using Register = juce::dsp::SIMDRegister<T>;
+        return Register::max (Register::expand (lo), Register::min (Register::expand (hi), x));
+    }
+
+    template <typename T>
+    inline juce::dsp::SIMDRegister<T> clamp (juce::dsp::SIMDRegister<T> x, juce::dsp::SIMDRegister<T> lo, juce::dsp::SIMDRegister<T> hi) noexcept
+    {
+        using Register = juce::dsp::SIMDRegister<T>;
+        return Register::max (lo, Register::min (hi, x));
+    }
+
+    /** Loads a register from an address with no alignment requirement, for
+        per-sample parameters read alongside aligned audio data.
+    */
+    inline Vec loadUnaligned (const float* data) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        return Vec::fromNative (_mm_loadu_ps (data));
+       #elif JUCE_USE_ARM_NEON
+        return Vec::fromNative (vld1q_f32 (data));
+       #else
+        Vec result;
+
+        for (size_t i = 0; i < Vec::size(); ++i)
+            result.set (i, data[i]);
+
+        return result;
+       #endif
+    }
+
+    inline juce::dsp::SIMDRegister<double> loadUnaligned (const double* data) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        return juce::dsp::SIMDRegister<double>::fromNative (_mm_loadu_pd (data));
+       #else
+        juce::dsp::SIMDRegister<double> result;
+
+        for (size_t i = 0; i < juce::dsp::SIMDRegister<double>::size(); ++i)
+            result.set (i, data[i]);
+
+        return result;
+       #endif
+    }
+
+    /** loadUnaligned for code that is generic over the register type. Other
+        registers (see WideRegister.h) specialise it.
+    */
+    template <typename Register>
+    struct UnalignedLoad
+    {
+        static Register load (const ScalarOf<Register>* data) noexcept    { return loadUnaligned (data); }
+    };
+
+    /** a / b. SIMDRegister has no division of its own. */
+    template <typename T>
+    inline EnableIfScalar<T> divide (T a, T b) noexcept    { return a / b; }
+
+    inline Vec divide (Vec a, Vec b) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        return Vec::fromNative (_mm_div_ps (a.value, b.value));
+       #elif JUCE_USE_ARM_NEON && defined (__aarch64__)
+        return Vec::fromNative (vdivq_f32 (a.value, b.value));
+       #else
+        Vec result;
+
+        for (size_t i = 0; i < Vec::size(); ++i)
+            result.set (i, a.get (i) / b.get (i));
+
+        return result;
+       #endif
+    }
+
+    inline juce::dsp::SIMDRegister<double> divide (juce::dsp::SIMDRegister<double> a, juce::dsp::SIMDRegister<double> b) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        return juce::dsp::SIMDRegister<double>::fromNative (_mm_div_pd (a.value, b.value));
+       #else
+        juce::dsp::SIMDRegister<double> result;
+
+        for (size_t i = 0; i < juce::dsp::SIMDRegister<double>::size(); ++i)
+            result.set (i, a.get (i) / b.get (i));
+
+        return result;
+       #endif
+    }
+
+    /** 2^n for an integral n in [-126, 127], built directly in the exponent bits. */
+    template <typename T>
+    inline EnableIfScalar<T> exp2Integer (T n) noexcept
+    {
+        return std::ldexp (T (1), static_cast<int> (n));
+    }
+
+    inline Vec exp2Integer (Vec n) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        auto bits = _mm_slli_epi32 (_mm_add_epi32 (_mm_cvttps_epi32 (n.value), _mm_set1_epi32 (127)), 23);
+        return Vec::fromNative (_mm_castsi128_ps (bits));
+       #elif JUCE_USE_ARM_NEON
+        auto bits = vshlq_n_s32 (vaddq_s32 (vcvtq_s32_f32 (n.value), vdupq_n_s32 (127)), 23);
+        return Vec::fromNative (vreinterpretq_f32_s32 (bits));
+       #else
+        Vec result;
+
+        for (size_t i = 0; i < Vec::size(); ++i)
+            result.set (i, exp2Integer (n.get (i)));
+
+        return result;
+       #endif
+    }
+
+    inline juce::dsp::SIMDRegister<double> exp2Integer (juce::dsp::SIMDRegister<double> n) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        // The biased exponent is always positive here, so zero-extending it to 64 bits is enough
+        auto biased = _mm_add_epi32 (_mm_cvttpd_epi32 (n.value), _mm_set1_epi32 (1023));
+        auto bits = _mm_slli_epi64 (_mm_unpacklo_epi32 (biased, _mm_setzero_si128()), 52);
+        return juce::dsp::SIMDRegister<double>::fromNative (_mm_castsi128_pd (bits));
+       #else
+        juce::dsp::SIMDRegister<double> result;
+
+        for (size_t i = 0; i < juce::dsp::SIMDRegister<double>::size(); ++i)
+            result.set (i, exp2Integer (n.get (i)));
+
+        return result;
+       #endif
+    }
+
+    //==============================================================================
+    /** asin (sin (x)): a triangle wave with period 2pi and peaks at +/- pi/2.
+        This is exact rather than an approximation, so it is shared by every tier.
+    */
+    template <typename T>
+    inline T fold (T x) noexcept
+    {
+        using Scalar = ScalarOf<T>;
+        constexpr auto halfPi = juce::MathConstants<Scalar>::halfPi;
+        constexpr auto twoPi  = juce::MathConstants<Scalar>::twoPi;
+
+        auto u = (x - halfPi) * (Scalar (1) / twoPi);
+        auto f = u - truncate (u);
+        return abs (abs (f) - Scalar (0.5)) * twoPi - halfPi;
+    }
+
+    /** sin (r) for r in [-pi/2, pi/2], minimax odd polynomial. */
+    template <Accuracy accuracy, typename T>
+    inline T sinHalfPi (T r) noexcept
+    {
+        auto r2 = r * r;
+
+        if constexpr (accuracy == Accuracy::fast)
+        {
+            auto p = r2 * 7.514377250e-3f + (-1.656730796e-1f);
+            p = p * r2 + 9.996967733e-1f;
+            return r * p;
+        }
+        else
+        {
+            auto p = r2 * 2.590488546e-6f + (-1.980089779e-4f);
+            p = p * r2 + 8.332899824e-3f;
+            p = p * r2 + (-1.666664763e-1f);
+            p = p * r2 + 9.999999766e-1f;
+            return r * p;
+        }
+    }
+
+    /** sin (x) for any x: folded into [-pi/2, pi/2], where sin (fold (x)) == sin (x). */
+    template <Accuracy accuracy, typename T>
+    inline T sin (T x) noexcept
+    {
+        if constexpr (accuracy == Accuracy::exact)
+            return std::sin (x);
+        else
+            return sinHalfPi<accuracy> (fold (x));
+    }
+
+    /** e^x, as 2^n * 2^f with n = floor (x / ln 2) and a minimax polynomial for
+        2^f on [0, 1). The argument is clamped to the normal float range.
+    */
+    template <Accuracy accuracy, typename T>
+    inline T exp (T x) noexcept
+    {
+        if constexpr (accuracy == Accuracy::exact)
+        {
+            return std::exp (x);
+        }
+        else
+        {
+            using Scalar = ScalarOf<T>;
+            auto y = clamp (x * Scalar (1.4426950408889634), Scalar (-126), Scalar (126)); // x / ln 2
+            auto n = floor (y);
+            auto f = y - n;
+            T p;
+
+            if constexpr (accuracy == Accuracy::fast)
+            {
+                p = f * 7.802452269e-2f + 2.260671554e-1f;
+                p = p * f + 6.958335405e-1f;
+                p = p * f + 9.999252186e-1f;
+            }
+            else
+            {
+                p = f * 1.877576700e-3f + 8.989340024e-3f;
+                p = p * f + 5.582631812e-2f;
+                p = p * f + 2.401536170e-1f;
+                p = p * f + 6.931530732e-1f;
+                p = p * f + 9.999999251e-1f;
+            }
+
+            return p * exp2Integer (n);
+        }
+    }
+}
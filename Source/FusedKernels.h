@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    FusedKernels.h
+
+    One pass over each channel group for the whole host-rate signal chain:
+    chorus, saturator, dry/wet and clipper. A group is interleaved with a
+    channel in every SIMD lane (see ChannelGroups.h), so each step of the
+    chain runs once for all of its channels. Every combination of stages,
+    saturation mode, clipper type and accuracy tier is its own template
+    instantiation, so the configuration is resolved once per block and a
+    disabled stage leaves no code behind in the loop.
+
+    The engine uses these when nothing runs at an oversampled rate and an
+    approximated accuracy tier is selected; otherwise it falls back to the
+    stage-by-stage block kernels, running only the chorus through here so
+    both paths share its state. Both paths evaluate the same curves, so
+    switching between them is seamless. Like the kernels it is built from,
+    everything here is a template on the sample type.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadBank.h"
+#include "ChannelGroups.h"
+#include "ChorusDelayLine.h"
+#include "SaturationKernels.h"
+#include <utility>
+
+namespace FusedKernels
+{
+    using FastMath::Accuracy;
+
+    enum ChorusStage
+    {
+        chorusOff = 0,
+        chorusLinear,
+        chorusLagrange,
+        chorusAllpass,
+        numChorusStages
+    };
+
+    /** 0 to SaturationKernels::numModes - 1 select a curve. With saturatorDeferred
+        the pass stops after the chorus, and the saturator runs later at an
+        oversampled rate.
+    */
+    enum SaturatorStage
+    {
+        saturatorOff = SaturationKernels::numModes,
+        saturatorDeferred,
+        numSaturatorStages
+    };
+
+    enum ClipperStage
+    {
+        clipperOff = 0,
+        clipperHard,
+        clipperSoft,
+        numClipperStages
+    };
+
+    struct Configuration
+    {
+        int chorus = chorusOff;
+        int saturator = saturatorOff;
+        int clipper = clipperOff;
+        Accuracy accuracy = Accuracy::accurate;
+    };
+
+    /** Everything one channel group's block needs. The chorus fields are only read
+        when the chorus is on. The continuous parameters come as SmoothedParameter
+        ramps, one value per sample, shared by every channel.
+    */
+    template <typename SampleType>
+    struct Context
+    {
+        using Register = juce::dsp::SIMDRegister<SampleType>;
+
+        Register* frames = nullptr;     // The group, interleaved: one register per sample
+        int numSamples = 0;
+
+        const SampleType* dryWetRamp = nullptr;   // Saturator dry/wet
+        const SampleType* driveRamp = nullptr;
+        const SampleType* thresholdRamp = nullptr;
+
+        ChorusDelayLine<SampleType>* delayLine = nullptr;
+        int group = 0;                                     // The group's line in delayLine
+        int numChorusVoices = 0;
+        const SampleType* const* chorusDelays = nullptr;   // Per voice, the delay in samples for every sample
+        const Register* chorusGains = nullptr;             // Per voice, its gain in each of the group's lanes
+        BiquadBank<SampleType>* filters = nullptr;         // A low-pass on the voices' mix for every group
+        const SampleType* chorusMixRamp = nullptr;
+    };
+
+    //==============================================================================
+    /** Processes one channel group in place. Call it for every group with the same
+        block, then advance the delay line and the filters once.
+    */
+    template <int chorus, int saturator, int clipper, Accuracy accuracy, typename SampleType>
+    void process (const Context<SampleType>& context) noexcept
+    {
+        static_assert (accuracy != Accuracy::exact, "The exact tier runs the stage-by-stage path");
+
+        using Register = typename Context<SampleType>::Register;
+        constexpr auto interpolation = static_cast<ChorusInterpolation> (chorus - chorusLinear);
+        const auto numSamples = context.numSamples;
+        auto* frames = context.frames;
+
+        [[maybe_unused]] Register* line = nullptr;
+        [[maybe_unused]] Register* states = nullptr;
+        [[maybe_unused]] int index = 0, mask = 0;
+
+        // The filter state is held locally through the block, so it can stay in registers
+        [[maybe_unused]] typename BiquadBank<SampleType>::State* filterState = nullptr;
+        [[maybe_unused]] typename BiquadBank<SampleType>::State filter;
+
+        if constexpr (chorus != chorusOff)
+        {
+            line = context.delayLine->getLine (context.group);
+            states = context.delayLine->getAllpassStates (context.group);
+            index = context.delayLine->getWriteIndex();
+            mask = context.delayLine->getMask();
+
+            filterState = context.filters->getStates (context.group);
+            filter = *filterState;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto clean = frames[i];
+            auto x = clean;
+
+            if constexpr (chorus != chorusOff)
+            {
+                line[index] = clean;
+
+                // Every voice taps the same line, panned and scaled into the mix. The
+                // filter is linear and shared, so filtering the mix once is the same
+                // as filtering each voice.
+                auto voices = Register::expand (0);
+
+                for (int voice = 0; voice < context.numChorusVoices; ++voice)
+                    voices += context.delayLine->template read<interpolation> (line, index, context.chorusDelays[voice][i], states[voice])
+                                * context.chorusGains[voice];
+
+                voices = filter.process (context.filters->getCoefficients (i), voices);
+
+                x += (voices - clean) * context.chorusMixRamp[i];
+                index = (index + 1) & mask;
+            }
+
+            if constexpr (saturator != saturatorDeferred)
+            {
+                // With the saturator off, the wet path is the signal before the chorus
+                Register wet;
+
+                if constexpr (saturator == saturatorOff)
+                    wet = clean;
+                else
+                    wet = SaturationKernels::shape<saturator, accuracy> (x, context.driveRamp[i]);
+
+                x += (wet - x) * context.dryWetRamp[i];
+            }
+
+            if constexpr (clipper == clipperHard)
+                x = FastMath::clamp (x, -context.thresholdRamp[i], context.thresholdRamp[i]);
+            else if constexpr (clipper == clipperSoft)
+                x = SaturationKernels::softClip<accuracy> (x, context.thresholdRamp[i]);
+
+            frames[i] = x;
+        }
+
+        if constexpr (chorus != chorusOff)
+        {
+            *filterState = filter;
+        }
+    }
+
+    //==============================================================================
+    namespace detail
+    {
+        /** Calls fn with std::integral_constant<int, value>, for value in Values. */
+        template <typename Fn, int... Values>
+        void withConstant (int value, std::integer_sequence<int, Values...>, Fn&& fn)
+        {
+            (void) ((value == Values ? (fn (std::integral_constant<int, Values>()), true) : false) || ...);
+        }
+    }
+
+    /** Runs the instantiation for configuration over one channel group in place.
+        configuration.accuracy must not be Accuracy::exact.
+    */
+    template <typename SampleType>
+    void process (const Configuration& configuration, const Context<SampleType>& context) noexcept
+    {
+        jassert (configuration.accuracy != Accuracy::exact);
+
+        detail::withConstant (configuration.chorus, std::make_integer_sequence<int, numChorusStages>(), [&] (auto chorus)
+        {
+            detail::withConstant (configuration.saturator, std::make_integer_sequence<int, numSaturatorStages>(), [&] (auto saturator)
+            {
+                detail::withConstant (configuration.clipper, std::make_integer_sequence<int, numClipperStages>(), [&] (auto clipper)
+                {
+                    if (configuration.accuracy == Accuracy::fast)
+                        process<chorus, saturator, clipper, Accuracy::fast> (context);
+                    else
+                        process<chorus, saturator, clipper, Accuracy::accurate> (context);
+                });
+            });
+        });
+    }
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.h
+
+    Every parameter value the signal chain needs for one block, as plain
+    values in a cache-line aligned struct. ClipSatEngine takes one per
+    block; the processor fills it from its parameters through
+    CachedParameters, and other hosts of the engine fill it themselves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusDelayLine.h"
+#include "FastMath.h"
+
+struct alignas (64) ParameterSnapshot
+{
+    // Continuous parameters, smoothed by the engine
+    float inputGain = 1.0f, outputGain = 1.0f;
+    float thresholdDecibels = 0.0f, thresholdGain = 1.0f;
+    float drive = 1.0f, dryWet = 0.0f;
+    float rate = 1.0f, depth = 0.0f, mix = 0.0f;
+    float tone = 4000.0f; // Chorus low-pass cutoff in Hz
+    float spread = 0.0f;  // How far apart the chorus voices are panned, 0 to 1
+
+    // Stage switches and choices, which only take effect at block boundaries
+    bool chorusOn = false, satOn = false, clipperOn = false, softClipping = false;
+    int saturationMode = 0;
+    int chorusVoices = 2; // 1 to ClipSatEngine::maxChorusVoices
+    int oversamplingStages = 0, oversamplingFilter = 0;
+    int antiAliasing = 0; // AntiderivativeKernels::Order
+    FastMath::Accuracy accuracy = FastMath::Accuracy::accurate;
+    ChorusInterpolation chorusInterpolation = ChorusInterpolation::linear;
+
+    /** Sets the threshold in decibels along with the gain the clipper uses. */
+    void setThresholdDecibels (float newThresholdDecibels) noexcept
+    {
+        thresholdDecibels = newThresholdDecibels;
+        thresholdGain = juce::Decibels::decibelsToGain (newThresholdDecibels);
+    }
+};
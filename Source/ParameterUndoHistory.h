@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    ParameterUndoHistory.h
+
+    Undo for the changes a user makes, and only those. The parameters'
+    ValueTree isn't given an UndoManager, because it records every change
+    the tree is synced with, host automation included, into one transaction
+    that grows for as long as the session runs. This records a parameter
+    change when a change gesture ends instead: gestures come from the
+    editor's controls, so automation and changes made on the audio thread
+    never reach the history.
+
+    Gestures on the same parameter in quick succession, like the steps of a
+    mouse wheel or repeated nudges, coalesce into one transaction. The
+    history is capped by the memory its actions take: once it is over
+    maxBytes, the oldest transactions are dropped.
+
+    Everything here runs on the message thread, except clear(), which hosts
+    may call from wherever they load a state.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+class ParameterUndoHistory : private juce::AudioProcessorParameter::Listener,
+                             private juce::AsyncUpdater
+{
+public:
+    static constexpr int maxBytes = 64 * 1024;
+    static constexpr int minimumTransactions = 8;   // Kept even if they go over maxBytes
+    static constexpr double coalesceSeconds = 0.5;
+
+    explicit ParameterUndoHistory (juce::AudioProcessor& processor)
+        : parameters (processor.getParameters()),
+          gestureStartValues (static_cast<size_t> (parameters.size()), 0.0f),
+          undoManager (maxBytes, minimumTransactions)
+    {
+        for (auto* parameter : parameters)
+            parameter->addListener (this);
+    }
+
+    ~ParameterUndoHistory() override
+    {
+        cancelPendingUpdate();
+
+        for (auto* parameter : parameters)
+            parameter->removeListener (this);
+    }
+
+    juce::UndoManager& getUndoManager() noexcept                { return undoManager; }
+    const juce::UndoManager& getUndoManager() const noexcept    { return undoManager; }
+
+    /** Forgets every transaction, as loading a new state does. Off the message
+        thread, it happens there as soon as it can.
+    */
+    void clear()
+    {
+        if (juce::MessageManager::existsAndIsCurrentThread())
+            handleAsyncUpdate();
+        else
+            triggerAsyncUpdate();
+    }
+
+private:
+    //==============================================================================
+    /** One parameter going from one normalised value to another. */
+    class ParameterChange : public juce::UndoableAction
+    {
+    public:
+        ParameterChange (ParameterUndoHistory& historyToUse, juce::AudioProcessorParameter& parameterToChange, float fromValue, float toValue)
+            : history (historyToUse), parameter (parameterToChange), from (fromValue), to (toValue)
+        {
+        }
+
+        bool perform() override    { history.apply (parameter, to); return true; }
+        bool undo() override       { history.apply (parameter, from); return true; }
+
+        // Bytes, with an allowance for the transaction holding the action
+        int getSizeInUnits() override    { return static_cast<int> (sizeof (*this)) + 64; }
+
+        juce::UndoableAction* createCoalescedAction (juce::UndoableAction* nextAction) override
+        {
+            if (auto* next = dynamic_cast<ParameterChange*> (nextAction))
+                if (&next->parameter == &parameter)
+                    return new ParameterChange (history, parameter, from, next->to);
+
+            return nullptr;
+        }
+
+    private:
+        ParameterUndoHistory& history;
+        juce::AudioProcessorParameter& parameter;
+        float from, to;
+    };
+
+    //==============================================================================
+    void parameterValueChanged (int, float) override {}
+
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override
+    {
+        // Undo and redo set parameters inside a gesture of their own, which isn't recorded
+        if (applying || ! juce::MessageManager::existsAndIsCurrentThread()
+             || ! juce::isPositiveAndBelow (parameterIndex, parameters.size()))
+            return;
+
+        auto* parameter = parameters.getUnchecked (parameterIndex);
+        auto& startValue = gestureStartValues[static_cast<size_t> (parameterIndex)];
+
+        if (gestureIsStarting)
+        {
+            startValue = parameter->getValue();
+            return;
+        }
+
+        const auto endValue = parameter->getValue();
+
+        if (endValue == startValue)
+            return;
+
+        // A gesture soon after the last one on the same parameter joins its transaction,
+        // where UndoManager coalesces the two changes into one
+        const auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        const bool coalesce = parameterIndex == lastGestureParameter && now - lastGestureEnd < coalesceSeconds;
+
+        if (! coalesce)
+            undoManager.beginNewTransaction (parameter->getName (64));
+
+        undoManager.perform (new ParameterChange (*this, *parameter, startValue, endValue));
+
+        lastGestureParameter = parameterIndex;
+        lastGestureEnd = now;
+    }
+
+    void handleAsyncUpdate() override
+    {
+        cancelPendingUpdate();
+        undoManager.clearUndoHistory();
+        lastGestureParameter = -1;
+    }
+
+    void apply (juce::AudioProcessorParameter& parameter, float value)
+    {
+        if (parameter.getValue() == value)
+            return;
+
+        const juce::ScopedValueSetter<bool> applyingSetter (applying, true);
+
+        // A gesture, so hosts writing automation record undo and redo like any other edit
+        parameter.beginChangeGesture();
+        parameter.setValueNotifyingHost (value);
+        parameter.endChangeGesture();
+
+        lastGestureParameter = -1;
+    }
+
+    //==============================================================================
+    const juce::Array<juce::AudioProcessorParameter*> parameters;
+    std::vector<float> gestureStartValues;
+    juce::UndoManager undoManager;
+
+    int lastGestureParameter = -1;
+    double lastGestureEnd = 0.0;
+    bool applying = false;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterUndoHistory)
+};
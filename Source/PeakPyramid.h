@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.h
+
+    Min/max peaks of a signal's recent history at several decimation levels,
+    for drawing long waveforms cheaply. Level 0 keeps one bucket per
+    baseSamplesPerBucket samples and every level above it merges pairs of
+    buckets from the one below, so level n covers baseSamplesPerBucket << n
+    samples per bucket. Each level is a ring holding the whole history.
+
+    push() only finishes the buckets the new samples complete, so the work is
+    proportional to what arrived rather than to the length of the history.
+    A view picks the level whose buckets are closest to one pixel column
+    and draws each bucket as a single vertical span.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+class PeakPyramid
+{
+public:
+    /** Allocates every level for historyInSamples of signal, and clears it. */
+    void prepare (int historyInSamples, int baseSamplesPerBucket, int numLevelsToUse)
+    {
+        baseBucketSize = juce::jmax (1, baseSamplesPerBucket);
+        levels.resize (static_cast<size_t> (juce::jmax (1, numLevelsToUse)));
+
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            auto& level = levels[i];
+            const int capacity = juce::jmax (1, historyInSamples / (baseBucketSize << i));
+
+            level.buckets.assign (static_cast<size_t> (capacity), {});
+            level.numWritten = 0;
+            level.pending = {};
+            level.numPending = 0;
+        }
+
+        pendingSamples = 0;
+        pendingPeak = {};
+    }
+
+    /** Adds samples to the end of the history. */
+    void push (const float* data, int numSamples) noexcept
+    {
+        if (levels.empty())
+            return;
+
+        while (numSamples > 0)
+        {
+            const int count = juce::jmin (numSamples, baseBucketSize - pendingSamples);
+            const auto range = juce::FloatVectorOperations::findMinAndMax (data, count);
+
+            pendingPeak = pendingSamples == 0 ? Peak { range.getStart(), range.getEnd() }
+                                              : merge (pendingPeak, { range.getStart(), range.getEnd() });
+            pendingSamples += count;
+            data += count;
+            numSamples -= count;
+
+            if (pendingSamples == baseBucketSize)
+            {
+                append (0, pendingPeak);
+                pendingSamples = 0;
+            }
+        }
+    }
+
+    int getNumLevels() const noexcept                        { return static_cast<int> (levels.size()); }
+    int getSamplesPerBucket (int level) const noexcept       { return baseBucketSize << level; }
+
+    /** The coarsest level whose buckets cover at most samplesPerColumn samples. */
+    int getLevelFor (double samplesPerColumn) const noexcept
+    {
+        int level = 0;
+
+        while (level + 1 < getNumLevels() && getSamplesPerBucket (level + 1) <= samplesPerColumn)
+            ++level;
+
+        return level;
+    }
+
+    /** How many buckets the level has completed since prepare(); it changes
+        exactly when new columns have arrived at that level.
+    */
+    juce::int64 getNumWritten (int level) const noexcept     { return levels[static_cast<size_t> (level)].numWritten; }
+
+    /** How many of the level's most recent buckets are available. */
+    int getNumAvailable (int level) const noexcept
+    {
+        const auto& l = levels[static_cast<size_t> (level)];
+        return static_cast<int> (juce::jmin (l.numWritten, static_cast<juce::int64> (l.buckets.size())));
+    }
+
+    /** A bucket's peaks, with 0 the most recent. index must be below getNumAvailable(). */
+    juce::Range<float> getPeak (int level, int index) const noexcept
+    {
+        const auto& l = levels[static_cast<size_t> (level)];
+        const auto size = static_cast<juce::int64> (l.buckets.size());
+        const auto& peak = l.buckets[static_cast<size_t> ((l.numWritten - 1 - index) % size)];
+        return { peak.min, peak.max };
+    }
+
+private:
+    struct Peak
+    {
+        float min = 0.0f, max = 0.0f;
+    };
+
+    struct Level
+    {
+        std::vector<Peak> buckets;
+        juce::int64 numWritten = 0;
+        Peak pending;
+        int numPending = 0;
+    };
+
+    static Peak merge (Peak a, Peak b) noexcept
+    {
+        return { juce::jmin (a.min, b.min), juce::jmax (a.max, b.max) };
+    }
+
+    // Stores a finished bucket, and carries it into the pair being built one level up
+    void append (size_t index, Peak peak) noexcept
+    {
+        for (; index < levels.size(); ++index)
+        {
+            auto& level = levels[index];
+            level.buckets[static_cast<size_t> (level.numWritten % static_cast<juce::int64> (level.buckets.size()))] = peak;
+            ++level.numWritten;
+
+            if (index + 1 == levels.size())
+                break;
+
+            auto& parent = levels[index + 1];
+            parent.pending = parent.numPending == 0 ? peak : merge (parent.pending, peak);
+
+            if (++parent.numPending < 2)
+                break;
+
+            peak = parent.pending;
+            parent.numPending = 0;
+        }
+    }
+
+    std::vector<Level> levels;
+    int baseBucketSize = 1;
+    int pendingSamples = 0;
+    Peak pendingPeak;
+};
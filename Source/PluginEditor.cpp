@@ -12,7 +12,7 @@
 
 //==============================================================================
 ClipSatAudioProcessorEditor::ClipSatAudioProcessorEditor (ClipSatAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p), audioVisualiser(2)
+    : AudioProcessorEditor (&p), audioProcessor (p), audioVisualiser(p.getVisualiserFeed()), cpuReadout(p.getProfiler())
 {
     //setSize(400, 300);
     setLookAndFeel(&abletonLookAndFeel);
@@ -189,13 +189,64 @@ ClipSatAudioProcessorEditor::ClipSatAudioProcessorEditor (ClipSatAudioProcessor&
     mixLabel.setJustificationType(juce::Justification::centred);
     addAndMakeVisible(mixLabel);
 
+    // Tone slider: the cutoff of the chorus voices' low-pass filters
+    toneSlider.setLookAndFeel(&abletonLookAndFeel);
+    toneSlider.setSliderStyle(juce::Slider::Rotary);
+    toneSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
+    addAndMakeVisible(toneSlider);
+    toneAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(audioProcessor.parameters, "tone", toneSlider));
+
+    toneLabel.setText("Tone", juce::dontSendNotification);
+    toneLabel.attachToComponent(&toneSlider, false);
+    toneLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(toneLabel);
+
+    // Ensemble: how many chorus voices, and how wide they are panned
+    chorusVoicesBox.addItemList(juce::StringArray{"1 Voice", "2 Voices", "3 Voices", "4 Voices", "5 Voices", "6 Voices", "7 Voices", "8 Voices"}, 1);
+    addAndMakeVisible(chorusVoicesBox);
+    chorusVoicesAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.parameters, "chorusVoices", chorusVoicesBox));
+
+    spreadSlider.setLookAndFeel(&abletonLookAndFeel);
+    spreadSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    spreadSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+    addAndMakeVisible(spreadSlider);
+    spreadAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(audioProcessor.parameters, "spread", spreadSlider));
+
+    spreadLabel.setText("Stereo Spread", juce::dontSendNotification);
+    spreadLabel.attachToComponent(&spreadSlider, true);
+    spreadLabel.setJustificationType(juce::Justification::centredRight);
+    addAndMakeVisible(spreadLabel);
+
+    // Oversampling factor and filter for the saturator/clipper stage
+    oversamplingBox.addItemList(juce::StringArray{"1x", "2x", "4x", "8x"}, 1);
+    addAndMakeVisible(oversamplingBox);
+    oversamplingAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.parameters, "oversampling", oversamplingBox));
+
+    oversamplingFilterBox.addItemList(juce::StringArray{"Polyphase IIR", "Linear Phase FIR"}, 1);
+    addAndMakeVisible(oversamplingFilterBox);
+    oversamplingFilterAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.parameters, "oversamplingFilter", oversamplingFilterBox));
+
+    // Exact for mastering, Fast for tracking
+    accuracyBox.addItemList(juce::StringArray{"Exact", "Accurate", "Fast"}, 1);
+    addAndMakeVisible(accuracyBox);
+    accuracyAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.parameters, "accuracy", accuracyBox));
+
+    // Fractional delay interpolation for the chorus
+    chorusInterpolationBox.addItemList(juce::StringArray{"Linear", "Lagrange", "Allpass"}, 1);
+    addAndMakeVisible(chorusInterpolationBox);
+    chorusInterpolationAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.parameters, "chorusInterpolation", chorusInterpolationBox));
+
+    // Antiderivative anti-aliasing for the saturator/clipper stage, with or without oversampling
+    antiAliasingBox.addItemList(juce::StringArray{"Off", "ADAA 1st Order", "ADAA 2nd Order"}, 1);
+    addAndMakeVisible(antiAliasingBox);
+    antiAliasingAttachment.reset(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.parameters, "antiAliasing", antiAliasingBox));
+
     
-    audioVisualiser.setBufferSize(512); // Set the buffer size for the visualiser
-    audioVisualiser.setSamplesPerBlock(256); // Set the number of samples per block
-    audioVisualiser.setColours(juce::Colours::black, juce::Colours::white); // Set the background and waveform colours
+    audioVisualiser.setHistoryLength(2.0); // Seconds of signal shown by the visualiser
     addAndMakeVisible(audioVisualiser);
+    addAndMakeVisible(cpuReadout); // Over the visualiser's top right corner
     
-    setSize(600, 400);
+    setSize(600, 480);
 }
 
 ClipSatAudioProcessorEditor::~ClipSatAudioProcessorEditor()
@@ -251,6 +302,9 @@ void ClipSatAudioProcessorEditor::resized()
     mixSlider.setBounds(xPosition, (area.getHeight() - sliderHeight) / 4, componentWidth, sliderHeight);
     xPosition += componentWidth + spacing;
 
+    toneSlider.setBounds(xPosition, (area.getHeight() - sliderHeight) / 4, componentWidth, sliderHeight);
+    xPosition += componentWidth + spacing;
+
     outputGainSlider.setBounds(xPosition, (area.getHeight() - sliderHeight) / 4, componentWidth, sliderHeight);
     xPosition += componentWidth + spacing;
 
@@ -269,6 +323,7 @@ void ClipSatAudioProcessorEditor::resized()
     int xPosition2 = (area.getWidth() - (componentWidth2 * totalComponents2 + totalSpacing2)) / 2;
     // Position the audio visualizer below the sliders
     audioVisualiser.setBounds(10, inputGainSlider.getBottom() + verticalOffset, area.getWidth() - 20, visualizerHeight);
+    cpuReadout.setBounds(audioVisualiser.getRight() - 300, audioVisualiser.getY() + 2, 295, 16);
 
     // Position the soft clipping button below the audio visualizer
     softClippingButton.setBounds(xPosition2, audioVisualiser.getBottom() + verticalOffset, componentWidth, buttonHeight);
@@ -282,6 +337,38 @@ void ClipSatAudioProcessorEditor::resized()
     
     chorusButton.setBounds(xPosition2, audioVisualiser.getBottom() + verticalOffset, componentWidth, buttonHeight);
     xPosition2 += componentWidth2 + spacing2;
+
+    // Settings row below the toggle buttons
+    int settingsY = chorusButton.getBottom() + spacing;
+    int totalComponents3 = 5; // Oversampling, Oversampling Filter, Accuracy, Chorus Interpolation and Anti-Aliasing
+    int totalSpacing3 = (totalComponents3 - 1) * spacing2;
+    int componentWidth3 = (area.getWidth() - totalSpacing3) / totalComponents3;
+    int xPosition3 = (area.getWidth() - (componentWidth3 * totalComponents3 + totalSpacing3)) / 2;
+
+    oversamplingBox.setBounds(xPosition3, settingsY, componentWidth3, buttonHeight);
+    xPosition3 += componentWidth3 + spacing2;
+
+    oversamplingFilterBox.setBounds(xPosition3, settingsY, componentWidth3, buttonHeight);
+    xPosition3 += componentWidth3 + spacing2;
+
+    accuracyBox.setBounds(xPosition3, settingsY, componentWidth3, buttonHeight);
+    xPosition3 += componentWidth3 + spacing2;
+
+    chorusInterpolationBox.setBounds(xPosition3, settingsY, componentWidth3, buttonHeight);
+    xPosition3 += componentWidth3 + spacing2;
+
+    antiAliasingBox.setBounds(xPosition3, settingsY, componentWidth3, buttonHeight);
+    xPosition3 += componentWidth3 + spacing2;
+
+    // Ensemble row below the settings: the voice count in the first column, then the
+    // spread slider with its label to its left
+    int ensembleY = settingsY + buttonHeight + spacing;
+    xPosition3 = (area.getWidth() - (componentWidth3 * totalComponents3 + totalSpacing3)) / 2;
+
+    chorusVoicesBox.setBounds(xPosition3, ensembleY, componentWidth3, buttonHeight);
+    xPosition3 += 2 * (componentWidth3 + spacing2);
+
+    spreadSlider.setBounds(xPosition3, ensembleY, 3 * componentWidth3 + 2 * spacing2, buttonHeight);
     
     
 }
@@ -11,40 +11,29 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "AbletonLookAndFeel.h"
+#include "PeakPyramid.h"
 
 //==============================================================================
 /**
 */
 
-class CustomAudioVisualiserComponent : public juce::AudioVisualiserComponent
+class CustomAudioVisualiserComponent : public juce::Component,
+                                       private juce::Timer
 {
     // Class definition...
     public:
-        CustomAudioVisualiserComponent(int numChannels) : AudioVisualiserComponent(numChannels) {
-            setBufferSize(1024); // Increase the buffer size for smoother waveforms
-            setSamplesPerBlock(256);
+        // Draws the processor's VisualiserFeed, drained on the message thread
+        // so the audio thread never touches the component
+        CustomAudioVisualiserComponent(VisualiserFeed& feedToUse) : feed(feedToUse) {
+            setHistoryLength(2.0);
+            startTimerHz(30);
         }
 
-    void pushInputBuffer(const juce::AudioBuffer<float>& buffer)
+        /** How many seconds of the most recent signal are drawn across the width. */
+        void setHistoryLength(double seconds)
         {
-            inputBuffer.clear();
-            inputBuffer.setSize(buffer.getNumChannels(), buffer.getNumSamples());
-            inputBuffer.copyFrom(0, 0, buffer, 0, 0, buffer.getNumSamples());
-            repaint();
-        }
-
-        void pushOutputBuffer(const juce::AudioBuffer<float>& buffer)
-        {
-            outputBuffer.clear();
-            outputBuffer.setSize(buffer.getNumChannels(), buffer.getNumSamples());
-            outputBuffer.copyFrom(0, 0, buffer, 0, 0, buffer.getNumSamples());
-            repaint();
-        }
-
-        void setThreshold(float newThreshold)
-        {
-            threshold = newThreshold;
-            repaint();
+            historySeconds = seconds;
+            preparedSampleRate = 0.0; // Re-sized on the next timer callback
         }
 
     protected:
@@ -55,56 +44,165 @@ class CustomAudioVisualiserComponent : public juce::AudioVisualiserComponent
 
             // Draw the input waveform in the top lane (in white)
             juce::Rectangle<float> inputLane(0, 0, getWidth(), laneHeight);
-            drawWaveform(g, inputBuffer, juce::Colours::white, inputLane);
+            drawWaveform(g, inputPeaks, juce::Colours::white, inputLane);
 
             // Draw the output waveform in the bottom lane (in red)
             juce::Rectangle<float> outputLane(0, laneHeight, getWidth(), laneHeight);
-            drawWaveform(g, outputBuffer, juce::Colours::green, outputLane); // Using 50% opacity for the output
+            drawWaveform(g, outputPeaks, juce::Colours::green, outputLane); // Using 50% opacity for the output
 
-            // Draw the threshold line in blue across both lanes
-            float y = juce::jmap<float>(threshold, -1.0f, 1.0f, static_cast<float>(getHeight()), 0.0f);
+            // Draw the threshold line in blue in each lane
             g.setColour(juce::Colours::blue.withAlpha(0.5f));
-            g.drawLine(0, y, getWidth(), y, 2.0f);
+
+            for (auto& lane : { inputLane, outputLane })
+            {
+                float y = juce::jmap<float>(threshold, -1.0f, 1.0f, lane.getBottom(), lane.getY());
+                g.drawLine(lane.getX(), y, lane.getRight(), y, 2.0f);
+            }
         }
 
     private:
-        void drawWaveform(juce::Graphics& g, const juce::AudioBuffer<float>& buffer, const juce::Colour& colour, const juce::Rectangle<float>& lane)
+        // Bucket sizes from 16 samples up to 16 << 11 (about 0.7s at 48kHz), so even
+        // long histories on narrow components get one bucket per pixel column
+        static constexpr int samplesPerBaseBucket = 16;
+        static constexpr int numPeakLevels = 12;
+
+        void timerCallback() override
+        {
+            const auto sampleRate = feed.sampleRate.load(std::memory_order_relaxed);
+
+            if (sampleRate != preparedSampleRate)
+            {
+                const int historySamples = juce::roundToInt(historySeconds * sampleRate);
+                inputPeaks.prepare(historySamples, samplesPerBaseBucket, numPeakLevels);
+                outputPeaks.prepare(historySamples, samplesPerBaseBucket, numPeakLevels);
+                preparedSampleRate = sampleRate;
+            }
+
+            drain(feed.input, inputPeaks);
+            drain(feed.output, outputPeaks);
+
+            // Only repaint when a new column has been completed at the level on screen
+            const int level = getDisplayLevel();
+            const auto written = inputPeaks.getNumWritten(level) + outputPeaks.getNumWritten(level);
+            const auto newThreshold = feed.threshold.load(std::memory_order_relaxed);
+
+            if (written != lastNumWritten || level != lastLevel || newThreshold != threshold)
+            {
+                lastNumWritten = written;
+                lastLevel = level;
+                threshold = newThreshold;
+                repaint();
+            }
+        }
+
+        void drain(VisualiserFifo& fifo, PeakPyramid& peaks)
+        {
+            int numRead;
+
+            while ((numRead = fifo.pull(scratch, scratchSize)) > 0)
+                peaks.push(scratch, numRead);
+        }
+
+        // The level whose buckets come closest to one pixel column for the history length
+        int getDisplayLevel() const
         {
+            return inputPeaks.getLevelFor(historySeconds * preparedSampleRate / juce::jmax(1, getWidth()));
+        }
+
+        // One vertical min/max span per pixel column of the lane, newest at its right edge
+        void drawWaveform(juce::Graphics& g, const PeakPyramid& peaks, const juce::Colour& colour, const juce::Rectangle<float>& lane)
+        {
+            if (peaks.getNumLevels() == 0)
+                return;
+
             g.setColour(colour);
-            for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+            const int level = getDisplayLevel();
+            const int width = static_cast<int>(lane.getWidth());
+            const int numColumns = juce::jmin(width, peaks.getNumAvailable(level));
+
+            for (int column = 0; column < numColumns; ++column)
             {
-                auto* channelData = buffer.getReadPointer(channel);
-                auto numSamples = buffer.getNumSamples();
-                auto bounds = getLocalBounds().toFloat();
-                auto width = bounds.getWidth();
-                auto height = bounds.getHeight();
-
-                juce::Path path;
-                
-                path.startNewSubPath(0, juce::jmap<float>(channelData[0], -1.0f, 1.0f, height, 0));
-
-                for (int sample = 0; sample < numSamples; ++sample)
-                {
-                    /*
-                    auto x = juce::jmap<int>(sample, 0, numSamples - 1, 0, static_cast<int>(lane.getWidth()));
-                    auto y = juce::jmap<float>(channelData[sample], -1.0f, 1.0f, lane.getBottom(), lane.getY());
-                    path.lineTo(x + lane.getX(), y);
-                     */
-                    
-                    float x = juce::jmap<float>(sample, 0, numSamples - 1, 0, width);
-                    float y = juce::jmap<float>(channelData[sample], -1.0f, 1.0f, height, 0);
-                    path.lineTo(x, y);
-                }
-
-                g.strokePath(path, juce::PathStrokeType(1.0f));
+                const auto peak = peaks.getPeak(level, column);
+                const auto top = juce::jmap<float>(peak.getEnd(), -1.0f, 1.0f, lane.getBottom(), lane.getY());
+                const auto bottom = juce::jmap<float>(peak.getStart(), -1.0f, 1.0f, lane.getBottom(), lane.getY());
+
+                g.fillRect(lane.getX() + static_cast<float>(width - 1 - column), top, 1.0f, juce::jmax(1.0f, bottom - top));
             }
         }
 
-        juce::AudioBuffer<float> inputBuffer;
-        juce::AudioBuffer<float> outputBuffer;
+        static constexpr int scratchSize = 1024;
+
+        VisualiserFeed& feed;
+        PeakPyramid inputPeaks, outputPeaks;
+        float scratch[scratchSize];
+        double historySeconds = 2.0;
+        double preparedSampleRate = 0.0;
+        juce::int64 lastNumWritten = -1;
+        int lastLevel = -1;
         float threshold = 0.0f;
     };
 
+//==============================================================================
+// The profiler's average load, worst block and overrun count, refreshed a few
+// times a second. Clicking it starts the counts again with every stage timed as
+// well; clicking again writes the full per-stage report to a file on the desktop
+// and goes back to timing whole blocks only.
+class CpuReadoutComponent : public juce::Component,
+                            private juce::Timer
+{
+public:
+    CpuReadoutComponent(StageProfiler& profilerToUse) : profiler(profilerToUse)
+    {
+        startTimerHz(4);
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        g.setColour(juce::Colours::white.withAlpha(0.6f));
+        g.setFont(12.0f);
+        g.drawText(text, getLocalBounds(), juce::Justification::centredRight);
+    }
+
+    void mouseDown(const juce::MouseEvent&) override
+    {
+        if (profiler.isStageTimingEnabled())
+        {
+            const auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+                                  .getNonexistentChildFile("ClipSat CPU Report", ".txt");
+
+            if (! profiler.writeReport(file))
+                return;
+
+            profiler.setStageTimingEnabled(false);
+        }
+        else
+        {
+            profiler.setStageTimingEnabled(true);
+        }
+
+        profiler.clear();
+        timerCallback();
+    }
+
+private:
+    void timerCallback() override
+    {
+        const auto snapshot = profiler.getSnapshot();
+        const auto newText = "CPU " + juce::String(snapshot.getAverageLoadPercent(), 1) + "%   worst block "
+                           + juce::String(snapshot.worstBlockPercent, 0) + "%   overruns " + juce::String(snapshot.getNumOverruns())
+                           + (profiler.isStageTimingEnabled() ? "   timing stages" : "");
+
+        if (newText != text)
+        {
+            text = newText;
+            repaint();
+        }
+    }
+
+    StageProfiler& profiler;
+    juce::String text;
+};
+
 class ClipSatAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
@@ -139,6 +237,14 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> depthAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> rateAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> toneAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> chorusVoicesAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> spreadAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingFilterAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> accuracyAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> chorusInterpolationAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> antiAliasingAttachment;
     
     juce::Label inputGainLabel;
     juce::Label thresholdLabel;
@@ -153,6 +259,8 @@ private:
     juce::Label rateLabel;
     juce::Label depthLabel;
     juce::Label mixLabel;
+    juce::Label toneLabel;
+    juce::Label spreadLabel;
     
     // UI components
     // GUI components
@@ -170,12 +278,21 @@ private:
     juce::Slider rateSlider;
     juce::Slider depthSlider;
     juce::Slider mixSlider;
+    juce::Slider toneSlider;
+    juce::ComboBox chorusVoicesBox;
+    juce::Slider spreadSlider;
+    juce::ComboBox oversamplingBox;
+    juce::ComboBox oversamplingFilterBox;
+    juce::ComboBox accuracyBox;
+    juce::ComboBox chorusInterpolationBox;
+    juce::ComboBox antiAliasingBox;
     
 
     
     
     //juce::AudioVisualiserComponent audioVisualiser; // Add this line
     CustomAudioVisualiserComponent audioVisualiser;
+    CpuReadoutComponent cpuReadout;
     AbletonLookAndFeel abletonLookAndFeel;
 
 
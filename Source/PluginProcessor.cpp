@@ -8,11 +8,10 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include <algorithm>
 
 //==============================================================================
 ClipSatAudioProcessor::ClipSatAudioProcessor()
-    : parameters (*this, &undoManager, "Parameters",
+    : parameters (*this, nullptr, "Parameters",
                     {
                         std::make_unique<juce::AudioParameterFloat>("inputGain", "Input Gain", 0.0f, 2.0f, 1.0f),
                         std::make_unique<juce::AudioParameterFloat>("threshold", "Threshold", juce::NormalisableRange<float>(-24.0f, 0.0f, 0.1f), -6.0f),
@@ -26,13 +25,31 @@ ClipSatAudioProcessor::ClipSatAudioProcessor()
                         std::make_unique<juce::AudioParameterFloat>("rate", "Rate", 0.1f, 10.0f, 1.0f),
                         std::make_unique<juce::AudioParameterFloat>("depth", "Depth", 0.0f, 0.50f, 0.1f),
                         std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 0.5f),
-                        std::make_unique<juce::AudioParameterBool>("chorusOnOff", "Chorus On/Off", true)
-                   })
+                        std::make_unique<juce::AudioParameterFloat>("tone", "Tone", juce::NormalisableRange<float>(500.0f, 16000.0f, 1.0f, 0.3f), 4000.0f),
+                        std::make_unique<juce::AudioParameterInt>("chorusVoices", "Chorus Voices", 1, 8, 2),
+                        std::make_unique<juce::AudioParameterFloat>("spread", "Stereo Spread", 0.0f, 1.0f, 0.0f),
+                        std::make_unique<juce::AudioParameterBool>("chorusOnOff", "Chorus On/Off", true),
+                        std::make_unique<juce::AudioParameterChoice>("oversampling", "Oversampling", juce::StringArray{"1x", "2x", "4x", "8x"}, 0),
+                        std::make_unique<juce::AudioParameterChoice>("oversamplingFilter", "Oversampling Filter", juce::StringArray{"Polyphase IIR", "Linear Phase FIR"}, 0),
+                        std::make_unique<juce::AudioParameterChoice>("accuracy", "Accuracy", juce::StringArray{"Exact", "Accurate", "Fast"}, 1),
+                        std::make_unique<juce::AudioParameterChoice>("chorusInterpolation", "Chorus Interpolation", juce::StringArray{"Linear", "Lagrange", "Allpass"}, 0),
+                        std::make_unique<juce::AudioParameterChoice>("antiAliasing", "Anti-Aliasing", juce::StringArray{"Off", "ADAA 1st Order", "ADAA 2nd Order"}, 0)
+                   }),
+      cachedParameters (parameters),
+      compactState (parameters),
+      undoHistory (*this)
 {
+    floatEngine.setVisualiserFeed (&visualiserFeed);
+    doubleEngine.setVisualiserFeed (&visualiserFeed);
+
+    // Only whole blocks are timed until the editor's CPU readout switches on the stage timing
+    floatEngine.setProfiler (&profiler);
+    doubleEngine.setProfiler (&profiler);
 }
 
 ClipSatAudioProcessor::~ClipSatAudioProcessor()
 {
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -43,18 +60,72 @@ void ClipSatAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    const int numInputChannels = getTotalNumInputChannels();
-    const int delayBufferSize = 2 * (sampleRate + samplesPerBlock);
-    delayBuffer.setSize(numInputChannels, delayBufferSize);
-    delayBuffer.clear();
-    delayBuffer2.setSize(numInputChannels, delayBufferSize);
-    delayBuffer2.clear();
-    delayBufferSamples = delayBufferSize;
-    delayBufferChannels = numInputChannels;
-    delayWritePosition = 0;
-    delayWritePosition2 = 0;
-    lowPassFilter1.setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, 4000.0));
-    lowPassFilter2.setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, 4000.0));
+
+    visualiserFeed.sampleRate.store(sampleRate);
+
+    const auto& settings = cachedParameters.update();
+    const int numChannels = getTotalNumInputChannels();
+    const auto layout = getChannelLayoutOfBus (true, 0);
+
+    preparedBlockSize = juce::jmax (1, samplesPerBlock);
+
+    // Only the engine for the precision the host will call us with is allocated,
+    // sharing the arena with its bypass fader. Hosts read the latency straight
+    // after prepareToPlay.
+    auto prepareChain = [&] (auto& engine, auto& bypass)
+    {
+        arena.layOut ([&] (DspArena& memory)
+        {
+            engine.prepare (sampleRate, preparedBlockSize, numChannels, settings, memory, layout);
+            bypass.prepare (sampleRate, preparedBlockSize, engine.getMaxLatencySamples(), numChannels, memory);
+        });
+
+        updateLatency (engine);
+    };
+
+    if (getProcessingPrecision() == doublePrecision)
+    {
+        floatEngine.release();
+        floatBypass.release();
+        prepareChain (doubleEngine, doubleBypass);
+    }
+    else
+    {
+        doubleEngine.release();
+        doubleBypass.release();
+        prepareChain (floatEngine, floatBypass);
+    }
+}
+
+template <typename SampleType>
+void ClipSatAudioProcessor::updateLatency (const ClipSatEngine<SampleType>& engine)
+{
+    engineLatency.store (engine.getLatencySamples(), std::memory_order_relaxed);
+    setLatencySamples (engine.getLatencySamples());
+}
+
+void ClipSatAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples (engineLatency.load (std::memory_order_relaxed));
+}
+
+MemoryFootprint ClipSatAudioProcessor::getMemoryFootprint() const
+{
+    MemoryFootprint footprint;
+    footprint.addArena (arena);
+
+    footprint.add ("Oversampling (estimate)", getProcessingPrecision() == doublePrecision ? doubleEngine.getOversamplingBytes()
+                                                                                          : floatEngine.getOversamplingBytes(), false);
+    footprint.add ("Visualiser FIFOs", 2 * VisualiserFeed::fifoSize * sizeof (float), false);
+    footprint.add ("Undo history", static_cast<size_t> (undoHistory.getUndoManager().getNumberOfUnitsTakenUpByStoredCommands()), false);
+    footprint.add ("Processor and engines", sizeof (*this), false);
+    return footprint;
+}
+
+void ClipSatAudioProcessor::setFusedProcessingEnabled (bool shouldBeEnabled) noexcept
+{
+    floatEngine.setFusedProcessingEnabled (shouldBeEnabled);
+    doubleEngine.setFusedProcessingEnabled (shouldBeEnabled);
 }
 
 void ClipSatAudioProcessor::releaseResources()
@@ -71,12 +142,12 @@ bool ClipSatAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout up to the engine's channel limit, mono and stereo included.
+    // Every channel is processed the same way, except that the chorus spread
+    // only pans across the layout's stereo pairs.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > ClipSatEngine<float>::maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -90,177 +161,77 @@ bool ClipSatAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 }
 #endif
 
-void ClipSatAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+bool ClipSatAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void ClipSatAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer, floatEngine, floatBypass, false);
+}
+
+void ClipSatAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer, doubleEngine, doubleBypass, false);
+}
+
+void ClipSatAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples (buffer, floatEngine, floatBypass, true);
+}
+
+void ClipSatAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
 {
-    juce::ScopedNoDenormals noDenormals;
+    processSamples (buffer, doubleEngine, doubleBypass, true);
+}
+
+template <typename SampleType>
+void ClipSatAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, ClipSatEngine<SampleType>& engine,
+                                            BypassFader<SampleType>& bypass, bool bypassed)
+{
+    // The whole block is timed, for the profiler's worst case and deadline histogram
+    profiler.beginBlock();
+    const auto blockStart = StageProfiler::now();
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
     // Clear any channels that are not being used
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
-    
-    // Retrieve parameter values
-    float inputGain = *parameters.getRawParameterValue("inputGain");
-    float threshold = juce::Decibels::decibelsToGain(parameters.getRawParameterValue("threshold")->load());
-    bool softClipping = *parameters.getRawParameterValue("softClipping");
-    bool clipperOnOff = *parameters.getRawParameterValue("clipperOnOff");
-    bool chorusOnOff = *parameters.getRawParameterValue("chorusOnOff");
-    bool satOnOff = *parameters.getRawParameterValue("satOnOff");
-    float driveParam = *parameters.getRawParameterValue("drive");
-    float dryWetParam = *parameters.getRawParameterValue("dryWet");
-    float saturationModeParam = *parameters.getRawParameterValue("saturationMode");
-    float outputGainValue = *parameters.getRawParameterValue("outputGain");
-    
-    auto* rateParam = parameters.getRawParameterValue("rate");
-    auto* depthParam = parameters.getRawParameterValue("depth");
-    auto* mixParam = parameters.getRawParameterValue("mix");
 
-    // Apply the input gain to the buffer
-    buffer.applyGain(inputGain);
-    
-    
-    // Push the input buffer to the visualizer before any processing
-    if (auto* editor = dynamic_cast<ClipSatAudioProcessorEditor*>(getActiveEditor()))
-        {
-            editor->getAudioVisualiser().pushInputBuffer(buffer);
-        }
-    
-    
-    auto numSamples = buffer.getNumSamples();
-    
+    // Coming back from a finished bypass, the chain starts again from silence
+    // rather than from wherever it stopped
+    if (! bypassed && bypass.isFullyBypassed())
+        engine.reset();
 
-    for (int sample = 0; sample < numSamples; ++sample)
-    {
-        // Smoothly update the parameter values
-        smoothedDrive += smoothingFactor * (driveParam - smoothedDrive);
-        smoothedDryWet += smoothingFactor * (dryWetParam - smoothedDryWet);
-        
-        auto inL = buffer.getReadPointer(0)[sample];
-        auto inR = buffer.getNumChannels() > 1 ? buffer.getReadPointer(1)[sample] : inL;
-
-        
-        lfoPhase += *rateParam * 0.01f; // LFO rate
-        if (lfoPhase >= juce::MathConstants<float>::twoPi)
-            lfoPhase -= juce::MathConstants<float>::twoPi;
-        
-        auto delayTime = (1.0f + std::sin(lfoPhase)) * 0.5f * *depthParam * 0.02f; // 20ms max delay
-
-        int delaySamples = static_cast<int>(delayTime * getSampleRate());
-
-        for (int channel = 0; channel < totalNumInputChannels; ++channel)
-        {
-            auto* channelData = buffer.getWritePointer(channel);
-            float cleanSignal = channelData[sample];
-            float saturatedSignal = cleanSignal;
-            
-            // apply chorus if toggled
-            if (chorusOnOff)
-            {
-                auto* delayData1 = delayBuffer.getWritePointer(channel);
-                auto* delayData2 = delayBuffer2.getWritePointer(channel);
-                
-                // Write the input signal into the delay buffers
-                delayData1[delayWritePosition] = cleanSignal;
-                delayData2[delayWritePosition2] = cleanSignal;
-
-                // Calculate the read positions for the delay buffers
-                int readPosition1 = delayWritePosition - static_cast<int>((1.0f + std::sin(lfoPhase)) * 0.5f * *depthParam * 0.02f * getSampleRate());
-                int readPosition2 = delayWritePosition2 - static_cast<int>((1.0f + std::sin(lfoPhase2)) * 0.5f * *depthParam * 0.02f * getSampleRate());
-
-                // Wrap the read positions if they go beyond the buffer bounds
-                if (readPosition1 < 0) readPosition1 += delayBufferSamples;
-                if (readPosition2 < 0) readPosition2 += delayBufferSamples;
-
-                // Read the delayed samples from the delay buffers
-                auto delaySample1 = delayData1[readPosition1];
-                auto delaySample2 = delayData2[readPosition2];
-
-                // Process the delayed samples through the low-pass filters
-                delaySample1 = lowPassFilter1.processSingleSampleRaw(delaySample1 + feedbackAmount * delaySample1);
-                delaySample2 = lowPassFilter2.processSingleSampleRaw(delaySample2 + feedbackAmount * delaySample2);
-
-                // Mix the delayed samples with the original signal
-                channelData[sample] = cleanSignal + (*mixParam * ((delaySample1 + delaySample2) - cleanSignal));
-            }
-                
-            
-            
-            float postChorusSignal = channelData[sample];
-            
-            // Apply the saturation effect based on the selected mode
-            if (satOnOff){
-                switch (static_cast<int>(saturationModeParam))
-                {
-                    case 0: // Soft Sine
-                        saturatedSignal = std::sin(driveParam * postChorusSignal);
-                        break;
-                    case 1: // Hard Curve
-                        saturatedSignal = postChorusSignal - std::pow(postChorusSignal, 3) * driveParam;
-                        break;
-                    case 2: // Analog Clip
-                        saturatedSignal = std::max(static_cast<float>(-driveParam), std::min(static_cast<float>(driveParam), postChorusSignal));
-                        break;
-                    case 3: // Sinoid Fold
-                        saturatedSignal = std::asin(std::sin(driveParam * postChorusSignal));
-                        break;
-                    default:
-                        break;
-                }
-            }
-            // Blend the processed (wet) signal with the original (dry) signal using smoothedDryWet
-            float mixedSignal = smoothedDryWet * saturatedSignal + (1 - smoothedDryWet) * postChorusSignal;
-
-            // Apply the output level control using smoothedOutput
-            channelData[sample] = mixedSignal;
-            
-            
-            float processedSample = mixedSignal;
-            
-            if (clipperOnOff){
-                if (softClipping)
-                {
-                    // Soft clipping
-                    if (processedSample > threshold)
-                        processedSample = threshold + (1 - expf(-processedSample + threshold));
-                    else if (processedSample < -threshold)
-                        processedSample = -threshold - (1 - expf(-processedSample - threshold));
-                }
-                else
-                {
-                    // Hard clipping
-                    if (processedSample > threshold)
-                        processedSample = threshold;
-                    else if (processedSample < -threshold)
-                        processedSample = -threshold;
-                }
-            }
-            channelData[sample] = processedSample;
-        }
-        lfoPhase += *rateParam * 0.01f;
-        lfoPhase2 += *rateParam * 0.012f; // Slightly different rate for the second LFO
+    // Retrieve parameter values, once for the whole block
+    const auto& settings = cachedParameters.update();
 
-        if (lfoPhase >= juce::MathConstants<float>::twoPi) lfoPhase -= juce::MathConstants<float>::twoPi;
-        if (lfoPhase2 >= juce::MathConstants<float>::twoPi) lfoPhase2 -= juce::MathConstants<float>::twoPi;
+    // Hosts may occasionally send more than the prepared block size. Everything was
+    // allocated for that size up front, so a longer block goes through in pieces.
+    for (int start = 0; start < buffer.getNumSamples(); start += preparedBlockSize)
+    {
+        const auto numSamples = juce::jmin (preparedBlockSize, buffer.getNumSamples() - start);
+        juce::AudioBuffer<SampleType> piece (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, numSamples);
 
-        if (++delayWritePosition >= delayBufferSamples) delayWritePosition = 0;
-        if (++delayWritePosition2 >= delayBufferSamples) delayWritePosition2 = 0;
+        // Once a fade to bypass has finished, the engine isn't called at all
+        bypass.process (piece, totalNumInputChannels, numSamples, engine.getLatencySamples(), bypassed, [&]
+        {
+            engine.process (piece.getArrayOfWritePointers(), totalNumInputChannels, numSamples, settings);
+        });
     }
-    
 
-    // Apply the output gain to the buffer
-    buffer.applyGain(outputGainValue);
-    
-    if (auto* editor = dynamic_cast<ClipSatAudioProcessorEditor*>(getActiveEditor()))
-        {
-            // Process your audio and store the result in the outputBuffer
-            juce::AudioBuffer<float> outputBuffer = buffer; // Replace this with your actual output buffer
-            editor->getAudioVisualiser().pushOutputBuffer(outputBuffer);
+    // Switching the oversampling changes the latency. Telling the host restarts it
+    // or sends it a property change, which mustn't happen on the audio thread.
+    if (engine.getLatencySamples() != engineLatency.load (std::memory_order_relaxed))
+    {
+        engineLatency.store (engine.getLatencySamples(), std::memory_order_relaxed);
+        triggerAsyncUpdate();
+    }
 
-            // Set the threshold value for the visualiser
-            float thresholdValue = juce::Decibels::decibelsToGain(parameters.getRawParameterValue("threshold")->load());
-            editor->getAudioVisualiser().setThreshold(thresholdValue);
-        }
+    profiler.addBlock (StageProfiler::now() - blockStart, buffer.getNumSamples(), getSampleRate());
 }
 
 //==============================================================================
@@ -297,7 +268,8 @@ bool ClipSatAudioProcessor::isMidiEffect() const
 
 double ClipSatAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return getProcessingPrecision() == doublePrecision ? doubleEngine.getTailLengthSeconds()
+                                                       : floatEngine.getTailLengthSeconds();
 }
 
 int ClipSatAudioProcessor::getNumPrograms()
@@ -321,18 +293,27 @@ void ClipSatAudioProcessor::changeProgramName(int index, const juce::String& new
 
 void ClipSatAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    compactState.write(destData);
 }
 
 void ClipSatAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    // Sessions saved since the compact format go straight into the parameters
+    if (compactState.read(data, sizeInBytes))
+    {
+        undoHistory.clear();
+        return;
+    }
+
+    // Older sessions saved the parameters' ValueTree as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
     if (xmlState != nullptr)
         if (xmlState->hasTagName(parameters.state.getType()))
+        {
             parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+            undoHistory.clear();
+        }
 }
 
 //==============================================================================
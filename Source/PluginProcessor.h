@@ -9,11 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "BypassFader.h"
+#include "ClipSatEngine.h"
+#include "CachedParameters.h"
+#include "CompactState.h"
+#include "DspArena.h"
+#include "ParameterUndoHistory.h"
+#include "StageProfiler.h"
+#include "VisualiserFeed.h"
 
 //==============================================================================
 /**
 */
-class ClipSatAudioProcessor  : public juce::AudioProcessor
+class ClipSatAudioProcessor  : public juce::AudioProcessor,
+                               private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -29,6 +38,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -62,29 +75,69 @@ public:
     
     juce::AudioProcessorValueTreeState parameters;
 
+    /** Lets processBlock use the fused per-configuration kernels whenever the
+        configuration allows it. Only the benchmarks turn this off, to time the
+        stage-by-stage path on its own.
+    */
+    void setFusedProcessingEnabled (bool shouldBeEnabled) noexcept;
+
+    /** The signal and threshold for the editor's visualiser, which drains it on its own timer. */
+    VisualiserFeed& getVisualiserFeed() noexcept    { return visualiserFeed; }
+
+    /** Where processBlock's time goes, stage by stage, for the editor's CPU readout. */
+    StageProfiler& getProfiler() noexcept    { return profiler; }
+
+    /** The instance's memory, subsystem by subsystem, as of the last prepareToPlay.
+        Message thread only, and not while the host is preparing the processor.
+    */
+    MemoryFootprint getMemoryFootprint() const;
+
+    /** The user's parameter edits, for undo and redo. Automation is never recorded. */
+    juce::UndoManager& getUndoManager() noexcept    { return undoHistory.getUndoManager(); }
+
 private:
     //==============================================================================
-    
-    juce::UndoManager undoManager;
+
+    // The parameters' atomics, resolved once, and the snapshot processBlock reads them into
+    CachedParameters cachedParameters;
+
+    // The saved state's binary format, with the parameters resolved once
+    CompactState compactState;
+
+    // Undo for the editor's gestures, bounded by memory
+    ParameterUndoHistory undoHistory;
     
     float outputGain = 1.0f; // Default output gain
-    float smoothedDrive = 0.0f;
-    float smoothedOutput = 0.0f;
-    float smoothedDryWet = 0.0f;
-    const float smoothingFactor = 0.01f; // Adjust this value to control the smoothing speed
-    
-    float lfoPhase = 0.0f;
-    juce::AudioSampleBuffer delayBuffer;
-    int delayBufferSamples = 0;
-    int delayBufferChannels = 0;
-    int delayWritePosition = 0;
-    
-    float lfoPhase2 = 0.0f;
-    juce::AudioSampleBuffer delayBuffer2;
-    int delayWritePosition2 = 0;
-    
-    juce::IIRFilter lowPassFilter1, lowPassFilter2; // Low-pass filters for each delay line
-    float feedbackAmount = 0.1f; // Feedback amount
+
+    // The prepared engine's and bypass fader's state, in one block sized by prepareToPlay.
+    // It comes before them so it outlives them.
+    DspArena arena;
+    int preparedBlockSize = 0;
+
+    // The signal chain, one per processing precision. Only the one for the
+    // current precision is prepared.
+    ClipSatEngine<float> floatEngine;
+    ClipSatEngine<double> doubleEngine;
+
+    // Fades to and from the latency-compensated dry signal when the host bypasses us
+    BypassFader<float> floatBypass;
+    BypassFader<double> doubleBypass;
+
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer, ClipSatEngine<SampleType>& engine,
+                         BypassFader<SampleType>& bypass, bool bypassed);
+
+    template <typename SampleType>
+    void updateLatency (const ClipSatEngine<SampleType>& engine);
+
+    // The engine's latency as the audio thread last saw it. A change is passed to
+    // the host from the message thread, as hosts expect.
+    std::atomic<int> engineLatency { 0 };
+
+    void handleAsyncUpdate() override;
+
+    VisualiserFeed visualiserFeed;
+    StageProfiler profiler;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ClipSatAudioProcessor)
 };
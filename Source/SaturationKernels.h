@@ -0,0 +1,327 @@
+/*
+  ==============================================================================
+
+    SaturationKernels.h
+
+    Block kernels for the four saturationMode curves and the soft/hard
+    clipper. Each kernel runs over a whole channel span with
+    juce::dsp::SIMDRegister, so the mode switch is taken once per block and
+    no libm calls are made per sample. Every kernel is a template on the
+    sample type, for the float and double processing paths, and takes its
+    drive or threshold either as one value for the block or as a per-sample
+    ramp while the parameter is being smoothed.
+
+    Soft Sine and Sinoid Fold share a branch-free triangle fold,
+    fold (x) == asin (sin (x)), which maps any argument into [-pi/2, pi/2];
+    Soft Sine then evaluates a polynomial for sin on that range. The
+    transcendental parts come from FastMath, in the selected accuracy tier.
+    The exact tier runs the original libm curves one sample at a time.
+
+    Tolerance of the accurate tier against the exact tier, measured over
+    |drive * x| <= 40:
+      - Soft Sine:   <= 4e-6 absolute (dominated by the float ulp of the
+                     argument at the top of that range)
+      - Hard Curve:  <= 1e-6 relative (the reference evaluates pow in double)
+      - Analog Clip: bit-exact
+      - Sinoid Fold: <= 4e-6 against the exact fold. libm's asinf (sinf (x))
+                     itself is off by up to 2.5e-4 right at the fold peaks,
+                     where asin is ill-conditioned, so that is the worst-case
+                     difference against the exact tier.
+      - Soft clip:   <= 1e-6 relative
+    The fast tier adds the FastMath fast-tier error on top: about 7e-5 for
+    Soft Sine and 2e-4 relative for the soft clipper.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include <cmath>
+
+namespace SaturationKernels
+{
+    enum SaturationMode
+    {
+        softSine = 0,
+        hardCurve,
+        analogClip,
+        sinoidFold,
+        numModes
+    };
+
+    using FastMath::Accuracy;
+
+    using FastMath::ScalarOf;
+
+    namespace detail
+    {
+        // The register the block kernels run on. The wider CPU dispatch variants
+        // build this header again around a register of their own (see SpanKernels.h).
+       #ifdef SATURATION_KERNELS_REGISTER
+        template <typename T> using Register = SATURATION_KERNELS_REGISTER<T>;
+       #else
+        template <typename T> using Register = juce::dsp::SIMDRegister<T>;
+       #endif
+
+        template <typename T> using Mask = typename Register<T>::vMaskType;
+
+        /** A drive or threshold that holds for the whole block. Registers see it as a scalar. */
+        template <typename T>
+        struct Constant
+        {
+            T value;
+
+            T get (int) const noexcept            { return value; }
+            T getRegister (int) const noexcept    { return value; }
+        };
+
+        /** A drive or threshold with one value per sample, from a SmoothedParameter ramp.
+            The ramp has no alignment of its own relative to the audio, so registers
+            are loaded unaligned.
+        */
+        template <typename T>
+        struct Ramp
+        {
+            const T* values;
+
+            T get (int i) const noexcept                     { return values[i]; }
+            Register<T> getRegister (int i) const noexcept   { return FastMath::UnalignedLoad<Register<T>>::load (values + i); }
+        };
+
+        /** Applies shaper (sample, parameter) to every sample, scalar up to the first
+            aligned address, SIMD through the body and scalar again for the tail.
+        */
+        template <typename SampleType, typename Parameter, typename Shaper>
+        inline void apply (SampleType* data, int numSamples, Parameter parameter, Shaper&& shaper) noexcept
+        {
+            using Vec = Register<SampleType>;
+            constexpr auto width = static_cast<int> (Vec::size());
+
+            auto head = juce::jmin (numSamples, static_cast<int> (Vec::getNextSIMDAlignedPtr (data) - data));
+            int i = 0;
+
+            for (; i < head; ++i)
+                data[i] = shaper (data[i], parameter.get (i));
+
+            for (; i + width <= numSamples; i += width)
+                shaper (Vec::fromRawArray (data + i), parameter.getRegister (i)).copyToRawArray (data + i);
+
+            for (; i < numSamples; ++i)
+                data[i] = shaper (data[i], parameter.get (i));
+        }
+
+        template <typename T>
+        inline FastMath::EnableIfScalar<T> select (bool condition, T a, T b) noexcept                  { return condition ? a : b; }
+
+        template <typename T>
+        inline Register<T> select (Mask<T> mask, Register<T> a, Register<T> b) noexcept                { return (a & mask) + (b & ~mask); }
+
+        template <typename T>
+        inline std::enable_if_t<std::is_floating_point_v<T>, bool> greaterThan (T a, T b) noexcept    { return a > b; }
+
+        template <typename T>
+        inline Mask<T> greaterThan (Register<T> a, T b) noexcept                                       { return Register<T>::greaterThan (a, Register<T>::expand (b)); }
+
+        template <typename T>
+        inline Mask<T> greaterThan (Register<T> a, Register<T> b) noexcept                             { return Register<T>::greaterThan (a, b); }
+
+        template <typename T>
+        inline std::enable_if_t<std::is_floating_point_v<T>, bool> lessThan (T a, T b) noexcept       { return a < b; }
+
+        template <typename T>
+        inline Mask<T> lessThan (Register<T> a, T b) noexcept                                          { return Register<T>::lessThan (a, Register<T>::expand (b)); }
+
+        template <typename T>
+        inline Mask<T> lessThan (Register<T> a, Register<T> b) noexcept                                { return Register<T>::lessThan (a, b); }
+    }
+
+    //==============================================================================
+    /** The original per-sample curves. This is the exact tier, and the reference
+        the approximated tiers are checked against.
+    */
+    template <typename SampleType>
+    inline SampleType reference (int mode, SampleType x, SampleType drive) noexcept
+    {
+        switch (mode)
+        {
+            case softSine:   return std::sin (drive * x);
+            case hardCurve:  return static_cast<SampleType> (x - std::pow (x, 3) * drive);
+            case analogClip: return std::max (-drive, std::min (drive, x));
+            case sinoidFold: return std::asin (std::sin (drive * x));
+            default:         return x;
+        }
+    }
+
+    template <typename SampleType>
+    inline SampleType softClipReference (SampleType x, SampleType threshold) noexcept
+    {
+        if (x > threshold)
+            return threshold + (1 - std::exp(-x + threshold));
+
+        if (x < -threshold)
+            return -threshold - (1 - std::exp(-x - threshold));
+
+        return x;
+    }
+
+    //==============================================================================
+    /** One sample, or one SIMD register, of the given curve in an approximated tier.
+        drive is either a scalar or a register of per-lane values.
+    */
+    template <int mode, Accuracy accuracy, typename T, typename Drive = ScalarOf<T>>
+    inline T shape (T x, Drive drive) noexcept
+    {
+        static_assert (accuracy != Accuracy::exact, "The exact tier only runs through reference()");
+
+        if constexpr (mode == softSine)
+            return FastMath::sin<accuracy> (x * drive);
+        else if constexpr (mode == hardCurve)
+            return x - x * x * x * drive;
+        else if constexpr (mode == analogClip)
+            return FastMath::clamp (x, drive * ScalarOf<T> (-1), drive);
+        else
+            return FastMath::fold (x * drive);
+    }
+
+    /** One sample, or one SIMD register, of the soft clipper in an approximated tier.
+        Both branches are evaluated and the result selected; FastMath::exp clamps
+        its argument, so the unused branch can't overflow.
+    */
+    template <Accuracy accuracy, typename T, typename Threshold = ScalarOf<T>>
+    inline T softClip (T x, Threshold threshold) noexcept
+    {
+        constexpr ScalarOf<T> one (1);
+
+        auto above = (FastMath::exp<accuracy> ((x - threshold) * -one) - one) * -one + threshold;
+        auto below = (FastMath::exp<accuracy> ((x + threshold) * -one) - one) - threshold;
+
+        return detail::select (detail::greaterThan (x, threshold), above,
+                               detail::select (detail::lessThan (x, threshold * -one), below, x));
+    }
+
+    //==============================================================================
+    template <Accuracy accuracy, typename SampleType, typename Parameter>
+    inline void softSineBlock (SampleType* data, int numSamples, Parameter drive) noexcept
+    {
+        detail::apply (data, numSamples, drive, [] (auto x, auto d) { return shape<softSine, accuracy> (x, d); });
+    }
+
+    template <typename SampleType, typename Parameter>
+    inline void hardCurveBlock (SampleType* data, int numSamples, Parameter drive) noexcept
+    {
+        detail::apply (data, numSamples, drive, [] (auto x, auto d) { return shape<hardCurve, Accuracy::accurate> (x, d); });
+    }
+
+    template <typename SampleType, typename Parameter>
+    inline void analogClipBlock (SampleType* data, int numSamples, Parameter drive) noexcept
+    {
+        detail::apply (data, numSamples, drive, [] (auto x, auto d) { return shape<analogClip, Accuracy::accurate> (x, d); });
+    }
+
+    template <typename SampleType, typename Parameter>
+    inline void sinoidFoldBlock (SampleType* data, int numSamples, Parameter drive) noexcept
+    {
+        detail::apply (data, numSamples, drive, [] (auto x, auto d) { return shape<sinoidFold, Accuracy::accurate> (x, d); });
+    }
+
+    namespace detail
+    {
+        template <typename SampleType, typename Parameter>
+        inline void processBlock (int mode, Accuracy accuracy, SampleType* data, int numSamples, Parameter drive) noexcept
+        {
+            if (accuracy == Accuracy::exact)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    data[i] = reference (mode, data[i], drive.get (i));
+
+                return;
+            }
+
+            switch (mode)
+            {
+                case softSine:
+                    if (accuracy == Accuracy::fast)
+                        softSineBlock<Accuracy::fast> (data, numSamples, drive);
+                    else
+                        softSineBlock<Accuracy::accurate> (data, numSamples, drive);
+                    break;
+
+                case hardCurve:  hardCurveBlock  (data, numSamples, drive); break;
+                case analogClip: analogClipBlock (data, numSamples, drive); break;
+                case sinoidFold: sinoidFoldBlock (data, numSamples, drive); break;
+                default: break;
+            }
+        }
+    }
+
+    template <Accuracy accuracy, typename SampleType, typename Parameter>
+    inline void softClipBlock (SampleType* data, int numSamples, Parameter threshold) noexcept
+    {
+        detail::apply (data, numSamples, threshold, [] (auto x, auto t) { return softClip<accuracy> (x, t); });
+    }
+
+    namespace detail
+    {
+        template <typename SampleType, typename Parameter>
+        inline void softClipBlock (Accuracy accuracy, SampleType* data, int numSamples, Parameter threshold) noexcept
+        {
+            switch (accuracy)
+            {
+                case Accuracy::exact:
+                    for (int i = 0; i < numSamples; ++i)
+                        data[i] = softClipReference (data[i], threshold.get (i));
+                    break;
+
+                case Accuracy::accurate: SaturationKernels::softClipBlock<Accuracy::accurate> (data, numSamples, threshold); break;
+                case Accuracy::fast:     SaturationKernels::softClipBlock<Accuracy::fast>     (data, numSamples, threshold); break;
+                default: break;
+            }
+        }
+    }
+
+    /** Runs the kernel for the given mode over one channel span in place. */
+    template <typename SampleType>
+    inline void processBlock (int mode, Accuracy accuracy, SampleType* data, int numSamples, SampleType drive) noexcept
+    {
+        detail::processBlock (mode, accuracy, data, numSamples, detail::Constant<SampleType> { drive });
+    }
+
+    /** As above, with the drive given per sample (a smoothing ramp). */
+    template <typename SampleType>
+    inline void processBlock (int mode, Accuracy accuracy, SampleType* data, int numSamples, const SampleType* drive) noexcept
+    {
+        detail::processBlock (mode, accuracy, data, numSamples, detail::Ramp<SampleType> { drive });
+    }
+
+    //==============================================================================
+    /** Soft clipping above +/- threshold, in place. */
+    template <typename SampleType>
+    inline void softClipBlock (Accuracy accuracy, SampleType* data, int numSamples, SampleType threshold) noexcept
+    {
+        detail::softClipBlock (accuracy, data, numSamples, detail::Constant<SampleType> { threshold });
+    }
+
+    /** As above, with the threshold given per sample (a smoothing ramp). */
+    template <typename SampleType>
+    inline void softClipBlock (Accuracy accuracy, SampleType* data, int numSamples, const SampleType* threshold) noexcept
+    {
+        detail::softClipBlock (accuracy, data, numSamples, detail::Ramp<SampleType> { threshold });
+    }
+
+    /** Hard clipping at +/- threshold, in place. */
+    template <typename SampleType>
+    inline void hardClipBlock (SampleType* data, int numSamples, SampleType threshold) noexcept
+    {
+        juce::FloatVectorOperations::clip (data, data, -threshold, threshold, numSamples);
+    }
+
+    /** As above, with the threshold given per sample (a smoothing ramp). */
+    template <typename SampleType>
+    inline void hardClipBlock (SampleType* data, int numSamples, const SampleType* threshold) noexcept
+    {
+        detail::apply (data, numSamples, detail::Ramp<SampleType> { threshold },
+                       [] (auto x, auto t) { return FastMath::clamp (x, t * ScalarOf<decltype (x)> (-1), t); });
+    }
+}
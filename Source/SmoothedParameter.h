@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    SmoothedParameter.h
+
+    One-pole smoothing for a continuous parameter, with its time constant in
+    milliseconds so it sounds the same at every sample rate.
+
+    process() is called once per block with the parameter's latest value.
+    While the value is moving it fills a ramp with one value per sample;
+    once it has settled within a small tolerance of its target it snaps to
+    it, fills the ramp with that constant once, and from then on returns
+    straight away until the target changes again. getRamp() is therefore
+    always valid for the current block, and consumers with a cheaper
+    constant path can check isSmoothing() and use getCurrentValue() instead.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspArena.h"
+#include <cmath>
+
+template <typename SampleType>
+class SmoothedParameter
+{
+public:
+    /** Sets the time constant (the time to cover 63% of a step), and allocates
+        the ramp from arena for the largest block process() will be called with.
+    */
+    void prepare (double sampleRate, double timeConstantMs, int maximumBlockSize, DspArena& arena)
+    {
+        coefficient = static_cast<SampleType> (1.0 - std::exp (-1000.0 / (timeConstantMs * sampleRate)));
+        rampSize = juce::jmax (1, maximumBlockSize);
+        ramp = arena.allocate<SampleType> (DspArena::smoothing, rampSize);
+    }
+
+    /** Jumps straight to value, without smoothing. */
+    void setCurrentAndTargetValue (SampleType value) noexcept
+    {
+        current = target = value;
+        settled = true;
+
+        if (ramp != nullptr)
+            std::fill (ramp, ramp + rampSize, value);
+    }
+
+    /** Moves towards newTarget over the next numSamples samples, which mustn't be
+        more than the prepared block size.
+    */
+    void process (SampleType newTarget, int numSamples) noexcept
+    {
+        jassert (numSamples <= rampSize);
+        target = newTarget;
+
+        if (settled)
+        {
+            if (target == current)
+                return;
+
+            settled = false;
+        }
+
+        if (std::abs (target - current) <= settleTolerance * juce::jmax (SampleType (1), std::abs (target)))
+        {
+            setCurrentAndTargetValue (target);
+            return;
+        }
+
+        auto* values = ramp;
+        auto value = current;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            value += coefficient * (target - value);
+            values[i] = value;
+        }
+
+        current = value;
+    }
+
+    bool isSmoothing() const noexcept                 { return ! settled; }
+    SampleType getCurrentValue() const noexcept       { return current; }
+    SampleType getTargetValue() const noexcept        { return target; }
+
+    /** The value for every sample of the last processed block. */
+    const SampleType* getRamp() const noexcept        { return ramp; }
+
+    /** Multiplies the first numSamples of every channel in buffer by this parameter. */
+    void applyGain (juce::AudioBuffer<SampleType>& buffer, int numSamples) const noexcept
+    {
+        if (! isSmoothing())
+        {
+            buffer.applyGain (0, numSamples, current);
+            return;
+        }
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::multiply (buffer.getWritePointer (channel), ramp, numSamples);
+    }
+
+private:
+    // About -100 dB relative to the target, well under anything audible
+    static constexpr SampleType settleTolerance = static_cast<SampleType> (1.0e-5);
+
+    SampleType* ramp = nullptr; // rampSize values, in the arena
+    int rampSize = 0;
+    SampleType current = 0, target = 0;
+    SampleType coefficient = 1;
+    bool settled = true;
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    SpanKernelVariant.h
+
+    A SpanKernels::Build of the SaturationKernels included before it. Each
+    SpanKernels*.cpp includes this inside an anonymous namespace, after
+    SaturationKernels.h, so every build keeps its own copy of the kernels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace SpanKernelVariant
+{
+    // SpanKernels.h's Accuracy and this build's are the same enumeration, declared twice
+    inline FastMath::Accuracy toAccuracy (::FastMath::Accuracy accuracy) noexcept
+    {
+        return static_cast<FastMath::Accuracy> (static_cast<int> (accuracy));
+    }
+
+    template <typename SampleType>
+    void saturate (int mode, ::FastMath::Accuracy accuracy, SampleType* data, int numSamples, SampleType drive) noexcept
+    {
+        SaturationKernels::processBlock (mode, toAccuracy (accuracy), data, numSamples, drive);
+    }
+
+    template <typename SampleType>
+    void saturateRamp (int mode, ::FastMath::Accuracy accuracy, SampleType* data, int numSamples, const SampleType* drive) noexcept
+    {
+        SaturationKernels::processBlock (mode, toAccuracy (accuracy), data, numSamples, drive);
+    }
+
+    template <typename SampleType>
+    void softClip (::FastMath::Accuracy accuracy, SampleType* data, int numSamples, SampleType threshold) noexcept
+    {
+        SaturationKernels::softClipBlock (toAccuracy (accuracy), data, numSamples, threshold);
+    }
+
+    template <typename SampleType>
+    void softClipRamp (::FastMath::Accuracy accuracy, SampleType* data, int numSamples, const SampleType* threshold) noexcept
+    {
+        SaturationKernels::softClipBlock (toAccuracy (accuracy), data, numSamples, threshold);
+    }
+
+    template <typename SampleType>
+    void hardClip (SampleType* data, int numSamples, SampleType threshold) noexcept
+    {
+        SaturationKernels::hardClipBlock (data, numSamples, threshold);
+    }
+
+    template <typename SampleType>
+    void hardClipRamp (SampleType* data, int numSamples, const SampleType* threshold) noexcept
+    {
+        SaturationKernels::hardClipBlock (data, numSamples, threshold);
+    }
+
+    template <typename SampleType>
+    void mixDryWet (SampleType* dry, SampleType* wet, int numSamples, const SampleType* mixRamp, SampleType mix) noexcept
+    {
+       #ifdef SATURATION_KERNELS_REGISTER
+        // One pass over the wide registers, rounding each step as the three passes below do
+        using Vec = SaturationKernels::detail::Register<SampleType>;
+        constexpr auto width = static_cast<int> (Vec::size());
+        const auto mixValue = Vec::expand (mix);
+        int i = 0;
+
+        for (; i + width <= numSamples; i += width)
+        {
+            auto d = Vec::fromRawArray (dry + i);
+            auto m = mixRamp != nullptr ? Vec::fromRawArray (mixRamp + i) : mixValue;
+            ((Vec::fromRawArray (wet + i) - d) * m + d).copyToRawArray (dry + i);
+        }
+
+        for (; i < numSamples; ++i)
+            dry[i] = (wet[i] - dry[i]) * (mixRamp != nullptr ? mixRamp[i] : mix) + dry[i];
+       #else
+        juce::FloatVectorOperations::subtract (wet, dry, numSamples);
+
+        if (mixRamp != nullptr)
+            juce::FloatVectorOperations::multiply (wet, mixRamp, numSamples);
+        else
+            juce::FloatVectorOperations::multiply (wet, mix, numSamples);
+
+        juce::FloatVectorOperations::add (dry, wet, numSamples);
+       #endif
+    }
+
+    template <typename SampleType>
+    constexpr SpanKernels::Table<SampleType> table { saturate<SampleType>, saturateRamp<SampleType>, softClip<SampleType>, softClipRamp<SampleType>,
+                                                     hardClip<SampleType>, hardClipRamp<SampleType>, mixDryWet<SampleType> };
+
+    // Constant-initialised, so nothing here runs before the CPU has been checked
+    const SpanKernels::Build& getBuild() noexcept
+    {
+        static constexpr SpanKernels::Build build { table<float>, table<double> };
+        return build;
+    }
+}
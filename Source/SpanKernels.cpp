@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+
+    SpanKernels.cpp
+
+    The baseline build of the span kernels, on juce::dsp::SIMDRegister.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SaturationKernels.h"
+#include "SpanKernels.h"
+
+namespace
+{
+   #include "SpanKernelVariant.h"
+}
+
+const SpanKernels::Build& SpanKernels::getBaselineBuild() noexcept
+{
+    return SpanKernelVariant::getBuild();
+}
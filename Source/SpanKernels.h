@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    SpanKernels.h
+
+    The kernels ClipSatEngine runs over whole channel spans at the
+    oversampled rate (the saturation curves, the soft and hard clippers and
+    the dry/wet mix) as a table of function pointers, so they can be built
+    more than once for different instruction sets and picked at runtime
+    (see CpuDispatch.h).
+
+    Each build is SaturationKernels.h compiled again in a translation unit
+    of its own: SpanKernels.cpp for the baseline, SSE2 or NEON, and
+    SpanKernelsAVX2.cpp and SpanKernelsAVX512.cpp for the wider registers
+    of WideRegister.h. Those two only target their instruction set inside
+    their own code, so nothing they compile leaks into the rest of the
+    plug-in, and their functions are only called on a CPU that has it.
+    None of the builds contracts multiplies and adds into FMAs, so all of
+    them give the same output, bit for bit. The one exception is the sign
+    of a zero out of the soft clipper, which comes out positive from a
+    register and keeps its sign in the scalar samples at the ends of a span;
+    where the ends fall depends on the register width.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <type_traits>
+
+// Declared here without FastMath.h, which the wide builds compile again with
+// their own instruction set
+namespace FastMath { enum class Accuracy; }
+
+namespace SpanKernels
+{
+    /** One build of the span kernels for one sample type. Every kernel works
+        in place on numSamples samples. Ramps hold one value per sample.
+    */
+    template <typename SampleType>
+    struct Table
+    {
+        /** SaturationKernels::processBlock. */
+        void (*saturate) (int mode, FastMath::Accuracy, SampleType* data, int numSamples, SampleType drive) noexcept;
+        void (*saturateRamp) (int mode, FastMath::Accuracy, SampleType* data, int numSamples, const SampleType* drive) noexcept;
+
+        /** SaturationKernels::softClipBlock. */
+        void (*softClip) (FastMath::Accuracy, SampleType* data, int numSamples, SampleType threshold) noexcept;
+        void (*softClipRamp) (FastMath::Accuracy, SampleType* data, int numSamples, const SampleType* threshold) noexcept;
+
+        /** SaturationKernels::hardClipBlock. */
+        void (*hardClip) (SampleType* data, int numSamples, SampleType threshold) noexcept;
+        void (*hardClipRamp) (SampleType* data, int numSamples, const SampleType* threshold) noexcept;
+
+        /** dry + mix * (wet - dry) into dry, with mix from mixRamp unless it is
+            nullptr. wet is left holding scratch.
+        */
+        void (*mixDryWet) (SampleType* dry, SampleType* wet, int numSamples, const SampleType* mixRamp, SampleType mix) noexcept;
+    };
+
+    /** The kernels of one instruction set, for both sample types. */
+    struct Build
+    {
+        Table<float> floatKernels;
+        Table<double> doubleKernels;
+
+        template <typename SampleType>
+        const Table<SampleType>& get() const noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+                return floatKernels;
+            else
+                return doubleKernels;
+        }
+    };
+
+    /** SSE2 on Intel, NEON on ARM: whatever juce::dsp::SIMDRegister is. Always there. */
+    const Build& getBaselineBuild() noexcept;
+
+    /** The wider builds, or nullptr where the compiler or platform can't make them.
+        Calling their kernels on a CPU without the instruction set crashes, so
+        check first (CpuDispatch does).
+    */
+    const Build* getAVX2Build() noexcept;
+    const Build* getAVX512Build() noexcept;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    SpanKernelsAVX2.cpp
+
+    The AVX2 build of the span kernels, on 256 bit registers. Only the code
+    in this file's anonymous namespace is compiled for AVX2, and FMA
+    contraction is switched off there so the output matches the baseline's.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SpanKernels.h"
+
+#if JUCE_INTEL && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if JUCE_CLANG
+ #pragma clang attribute push (__attribute__ ((target ("avx2"))), apply_to = function)
+ #pragma STDC FP_CONTRACT OFF
+#else
+ #pragma GCC push_options
+ #pragma GCC target ("avx2")
+ #pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace
+{
+   #include "FastMath.h"
+   #include "WideRegister.h"
+
+    template <typename T> using AVX2Register = FastMath::WideRegister<T, 32>;
+
+   #define SATURATION_KERNELS_REGISTER AVX2Register
+   #include "SaturationKernels.h"
+   #include "SpanKernelVariant.h"
+   #undef SATURATION_KERNELS_REGISTER
+}
+
+#if JUCE_CLANG
+ #pragma clang attribute pop
+#else
+ #pragma GCC pop_options
+#endif
+
+const SpanKernels::Build* SpanKernels::getAVX2Build() noexcept
+{
+    return &SpanKernelVariant::getBuild();
+}
+
+#else
+
+const SpanKernels::Build* SpanKernels::getAVX2Build() noexcept
+{
+    return nullptr;
+}
+
+#endif
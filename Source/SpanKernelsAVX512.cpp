@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    SpanKernelsAVX512.cpp
+
+    The AVX-512 build of the span kernels, on 512 bit registers. Only the
+    code in this file's anonymous namespace is compiled for AVX-512F, and
+    FMA contraction is switched off there so the output matches the
+    baseline's.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SpanKernels.h"
+
+#if JUCE_INTEL && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if JUCE_CLANG
+ #pragma clang attribute push (__attribute__ ((target ("avx512f"))), apply_to = function)
+ #pragma STDC FP_CONTRACT OFF
+#else
+ #pragma GCC push_options
+ #pragma GCC target ("avx512f")
+ #pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace
+{
+   #include "FastMath.h"
+   #include "WideRegister.h"
+
+    template <typename T> using AVX512Register = FastMath::WideRegister<T, 64>;
+
+   #define SATURATION_KERNELS_REGISTER AVX512Register
+   #include "SaturationKernels.h"
+   #include "SpanKernelVariant.h"
+   #undef SATURATION_KERNELS_REGISTER
+}
+
+#if JUCE_CLANG
+ #pragma clang attribute pop
+#else
+ #pragma GCC pop_options
+#endif
+
+const SpanKernels::Build* SpanKernels::getAVX512Build() noexcept
+{
+    return &SpanKernelVariant::getBuild();
+}
+
+#else
+
+const SpanKernels::Build* SpanKernels::getAVX512Build() noexcept
+{
+    return nullptr;
+}
+
+#endif
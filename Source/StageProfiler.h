@@ -0,0 +1,295 @@
+/*
+  ==============================================================================
+
+    StageProfiler.h
+
+    Where the audio thread's time goes, so an xrun can be put down to a
+    stage of the chain. processBlock records the time of the whole block:
+    the worst block so far, and a histogram of block times against the
+    block's deadline, numSamples / sampleRate. That is two clock reads a
+    block and always on. While stage timing is switched on, ClipSatEngine
+    also adds the high resolution ticks each stage takes to a counter per
+    stage, which reads the clock at every stage of every sub-block, so it
+    is off unless someone is looking (the chain benchmark's "profiler"
+    cases measure what it costs).
+
+    Every counter is a relaxed atomic with the audio thread as its only
+    writer, so updating one is a plain load and store, with no locked
+    instructions, and the editor can read them whenever it likes. A reading
+    taken mid-block may have some of that block's counts and not others,
+    which doesn't matter for a profile. Clearing is only requested from
+    other threads; the audio thread does it at the start of its next block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        inputGain = 0,
+        chorus,
+        oversampling,   // Up and down, around the saturator and clipper
+        saturation,
+        clipping,
+        fusedChain,     // Chorus, saturator and clipper in one pass (see FusedKernels.h)
+        outputGain,
+        visualiser,
+        other,          // Parameter smoothing, silence detection and the rest of the engine
+        numStages
+    };
+
+    static const char* getStageName (int stage) noexcept
+    {
+        static const char* const names[] = { "Input gain", "Chorus", "Oversampling", "Saturation", "Clipping",
+                                             "Fused chain", "Output gain", "Visualiser", "Other" };
+        return juce::isPositiveAndBelow (stage, static_cast<int> (numStages)) ? names[stage] : "";
+    }
+
+    // The histogram's buckets, by block time as a percentage of the deadline: below
+    // each limit in turn, and the last bucket for everything from 150% up
+    static constexpr int numBuckets = 7;
+    static constexpr int bucketLimits[numBuckets - 1] = { 10, 25, 50, 75, 100, 150 };
+
+    using Ticks = juce::int64;
+
+    static Ticks now() noexcept    { return juce::Time::getHighResolutionTicks(); }
+
+    static double ticksToSeconds (Ticks ticks) noexcept
+    {
+        return static_cast<double> (ticks) / static_cast<double> (juce::Time::getHighResolutionTicksPerSecond());
+    }
+
+    //==============================================================================
+    /** Adds the time from the last lap, or from start(), to a stage at each lap,
+        and hands the totals to the profiler at stop(), so a block that runs the
+        chain many times over updates each counter once. Without a profiler, or
+        with its stage timing off at start(), it does nothing.
+    */
+    class Timer
+    {
+    public:
+        Timer() = default;
+        explicit Timer (StageProfiler* profilerToUse) noexcept : profiler (profilerToUse) {}
+
+        void start() noexcept
+        {
+            timing = profiler != nullptr && profiler->isStageTimingEnabled();
+
+            if (timing)
+                last = now();
+        }
+
+        void lap (Stage stage) noexcept
+        {
+            if (timing)
+            {
+                const auto time = now();
+                ticks[stage] += time - last;
+                last = time;
+            }
+        }
+
+        void stop() noexcept
+        {
+            if (! timing)
+                return;
+
+            for (int stage = 0; stage < numStages; ++stage)
+            {
+                if (ticks[stage] != 0)
+                {
+                    profiler->addStageTicks (static_cast<Stage> (stage), ticks[stage]);
+                    ticks[stage] = 0;
+                }
+            }
+
+            timing = false;
+        }
+
+    private:
+        StageProfiler* profiler = nullptr;
+        Ticks last = 0;
+        Ticks ticks[numStages] = {};
+        bool timing = false;
+    };
+
+    /** Any thread: switches the per-stage timing on or off from the next block. */
+    void setStageTimingEnabled (bool shouldBeEnabled) noexcept    { stageTimingEnabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+
+    bool isStageTimingEnabled() const noexcept    { return stageTimingEnabled.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Audio thread only. */
+    void addStageTicks (Stage stage, Ticks ticks) noexcept
+    {
+        add (stageTicks[stage], ticks);
+    }
+
+    /** Audio thread only: one whole block of numSamples at sampleRate took ticks. */
+    void addBlock (Ticks ticks, int numSamples, double sampleRate) noexcept
+    {
+        const auto deadline = numSamples / sampleRate;
+        const auto percent = deadline > 0.0 ? 100.0 * ticksToSeconds (ticks) / deadline : 0.0;
+
+        int bucket = 0;
+
+        while (bucket < numBuckets - 1 && percent >= bucketLimits[bucket])
+            ++bucket;
+
+        add (buckets[bucket], 1);
+        add (numBlocks, 1);
+        add (blockTicks, ticks);
+        add (deadlineSeconds, deadline);
+
+        if (ticks > worstBlockTicks.load (std::memory_order_relaxed))
+        {
+            worstBlockTicks.store (ticks, std::memory_order_relaxed);
+            worstBlockPercent.store (percent, std::memory_order_relaxed);
+        }
+    }
+
+    /** Audio thread only, before the block: clears the counters if clear() was called. */
+    void beginBlock() noexcept
+    {
+        if (! clearRequested.load (std::memory_order_relaxed))
+            return;
+
+        clearRequested.store (false, std::memory_order_relaxed);
+
+        for (auto& counter : stageTicks)
+            counter.store (0, std::memory_order_relaxed);
+
+        for (auto& counter : buckets)
+            counter.store (0, std::memory_order_relaxed);
+
+        for (auto* counter : { &numBlocks, &blockTicks, &worstBlockTicks })
+            counter->store (0, std::memory_order_relaxed);
+
+        deadlineSeconds.store (0.0, std::memory_order_relaxed);
+        worstBlockPercent.store (0.0, std::memory_order_relaxed);
+    }
+
+    /** Any thread: starts the counts again from the audio thread's next block. */
+    void clear() noexcept    { clearRequested.store (true, std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** The counters, as read at one moment. */
+    struct Snapshot
+    {
+        Ticks stageTicks[numStages] = {};
+        juce::int64 buckets[numBuckets] = {};
+        juce::int64 numBlocks = 0;
+        Ticks blockTicks = 0, worstBlockTicks = 0;
+        double deadlineSeconds = 0.0, worstBlockPercent = 0.0;
+
+        /** The time spent processing, as a percentage of the audio it covered. */
+        double getAverageLoadPercent() const noexcept
+        {
+            return deadlineSeconds > 0.0 ? 100.0 * ticksToSeconds (blockTicks) / deadlineSeconds : 0.0;
+        }
+
+        /** Blocks that took longer than their deadline. */
+        juce::int64 getNumOverruns() const noexcept    { return buckets[numBuckets - 2] + buckets[numBuckets - 1]; }
+    };
+
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+
+        for (int stage = 0; stage < numStages; ++stage)
+            snapshot.stageTicks[stage] = stageTicks[stage].load (std::memory_order_relaxed);
+
+        for (int bucket = 0; bucket < numBuckets; ++bucket)
+            snapshot.buckets[bucket] = buckets[bucket].load (std::memory_order_relaxed);
+
+        snapshot.numBlocks = numBlocks.load (std::memory_order_relaxed);
+        snapshot.blockTicks = blockTicks.load (std::memory_order_relaxed);
+        snapshot.worstBlockTicks = worstBlockTicks.load (std::memory_order_relaxed);
+        snapshot.deadlineSeconds = deadlineSeconds.load (std::memory_order_relaxed);
+        snapshot.worstBlockPercent = worstBlockPercent.load (std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    /** A plain text table of every stage's share of the time, the worst block and
+        the histogram. The time processBlock spends outside the engine, reading the
+        parameters and fading the host bypass, is the block total less the stages.
+    */
+    juce::String getReport() const
+    {
+        const auto snapshot = getSnapshot();
+        const auto numBlocks = juce::jmax (static_cast<juce::int64> (1), snapshot.numBlocks);
+        juce::String report;
+
+        auto addLine = [&] (const juce::String& name, Ticks ticks)
+        {
+            const auto share = snapshot.blockTicks > 0 ? 100.0 * static_cast<double> (ticks) / static_cast<double> (snapshot.blockTicks) : 0.0;
+            report << name.paddedRight (' ', 16) << juce::String (1.0e6 * ticksToSeconds (ticks) / static_cast<double> (numBlocks), 3).paddedLeft (' ', 12)
+                   << " us/block" << juce::String (share, 1).paddedLeft (' ', 8) << " %\n";
+        };
+
+        report << "Blocks: " << snapshot.numBlocks << ", average load "
+               << juce::String (snapshot.getAverageLoadPercent(), 2) << " % of real time\n"
+               << "Worst block: " << juce::String (1.0e6 * ticksToSeconds (snapshot.worstBlockTicks), 1) << " us, "
+               << juce::String (snapshot.worstBlockPercent, 1) << " % of its deadline\n\n";
+
+        if (isStageTimingEnabled())
+        {
+            Ticks stagesTotal = 0;
+
+            for (int stage = 0; stage < numStages; ++stage)
+            {
+                addLine (getStageName (stage), snapshot.stageTicks[stage]);
+                stagesTotal += snapshot.stageTicks[stage];
+            }
+
+            addLine ("Outside engine", juce::jmax (static_cast<Ticks> (0), snapshot.blockTicks - stagesTotal));
+        }
+        else
+        {
+            report << "Stage timing is off, so only whole blocks were timed\n";
+        }
+
+        addLine ("Whole block", snapshot.blockTicks);
+
+        report << "\nBlock time against its deadline\n";
+
+        for (int bucket = 0; bucket < numBuckets; ++bucket)
+        {
+            const auto range = bucket == 0 ? "< " + juce::String (bucketLimits[0]) + " %"
+                             : bucket == numBuckets - 1 ? ">= " + juce::String (bucketLimits[numBuckets - 2]) + " %"
+                             : juce::String (bucketLimits[bucket - 1]) + " - " + juce::String (bucketLimits[bucket]) + " %";
+
+            report << range.paddedRight (' ', 16) << juce::String (snapshot.buckets[bucket]).paddedLeft (' ', 12) << "\n";
+        }
+
+        return report;
+    }
+
+    /** Writes getReport() to file, replacing it. Returns false if it can't be written. */
+    bool writeReport (const juce::File& file) const
+    {
+        return file.replaceWithText (getReport());
+    }
+
+private:
+    template <typename ValueType, typename AmountType>
+    static void add (std::atomic<ValueType>& counter, AmountType amount) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + static_cast<ValueType> (amount), std::memory_order_relaxed);
+    }
+
+    std::atomic<Ticks> stageTicks[numStages] = {};
+    std::atomic<juce::int64> buckets[numBuckets] = {};
+    std::atomic<juce::int64> numBlocks { 0 };
+    std::atomic<Ticks> blockTicks { 0 }, worstBlockTicks { 0 };
+    std::atomic<double> deadlineSeconds { 0.0 }, worstBlockPercent { 0.0 };
+    std::atomic<bool> clearRequested { false };
+    std::atomic<bool> stageTimingEnabled { false };
+};
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    VisualiserFeed.h
+
+    Carries the signal the editor draws from the audio thread to the message
+    thread. Each VisualiserFifo is a single-producer/single-consumer ring
+    on juce::AbstractFifo, allocated up front: processBlock pushes into it
+    without locks or allocation, and the visualiser drains it on its own
+    timer. When nothing is draining (no editor open) the ring fills up and
+    further pushes are dropped, which costs next to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+class VisualiserFifo
+{
+public:
+    explicit VisualiserFifo (int capacity)
+        : fifo (capacity), samples (static_cast<size_t> (capacity))
+    {
+    }
+
+    /** Audio thread only. Writes as much of data as fits and drops the rest. */
+    template <typename SampleType>
+    void push (const SampleType* data, int numSamples) noexcept
+    {
+        const auto scope = fifo.write (numSamples);
+
+        copy (samples.data() + scope.startIndex1, data, scope.blockSize1);
+        copy (samples.data() + scope.startIndex2, data + scope.blockSize1, scope.blockSize2);
+    }
+
+    /** Message thread only. Reads up to maxSamples into destination, oldest
+        first, and returns how many were read.
+    */
+    int pull (float* destination, int maxSamples) noexcept
+    {
+        const auto scope = fifo.read (juce::jmin (maxSamples, fifo.getNumReady()));
+
+        copy (destination, samples.data() + scope.startIndex1, scope.blockSize1);
+        copy (destination + scope.blockSize1, samples.data() + scope.startIndex2, scope.blockSize2);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    int getNumReady() const noexcept    { return fifo.getNumReady(); }
+
+private:
+    // The visualiser draws in float whichever precision the processor runs at
+    template <typename SampleType>
+    static void copy (float* destination, const SampleType* source, int numSamples) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::copy (destination, source, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = static_cast<float> (source[i]);
+        }
+    }
+
+    juce::AbstractFifo fifo;
+    std::vector<float> samples;
+
+    JUCE_DECLARE_NON_COPYABLE (VisualiserFifo)
+};
+
+//==============================================================================
+/** Everything the visualiser shows: the first channel before and after
+    processing, the clipper threshold as a gain, and the sample rate the
+    signal is at.
+*/
+struct VisualiserFeed
+{
+    // About 0.7s at 48kHz, far more than arrives between two timer callbacks
+    static constexpr int fifoSize = 1 << 15;
+
+    VisualiserFifo input { fifoSize };
+    VisualiserFifo output { fifoSize };
+    std::atomic<float> threshold { 1.0f };
+    std::atomic<double> sampleRate { 44100.0 };
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    WideRegister.h
+
+    A SIMD register wider than juce::dsp::SIMDRegister, which is 128 bits on
+    every platform, for the AVX2 and AVX-512 builds of the span kernels (see
+    SpanKernels.h). It is written with the GCC and Clang vector extensions,
+    so it becomes whatever instructions the including code is compiled for,
+    and has the part of SIMDRegister's interface that FastMath and
+    SaturationKernels use.
+
+    Every operation rounds as its SSE2 counterpart does, lane for lane, so
+    the wide kernels give the same results bit for bit: min and max return
+    the same operand on ties, truncation goes through 32 bit integers for
+    double too, and loads and stores need no alignment.
+
+    Only the span kernel variants include this, after FastMath.h.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace FastMath
+{
+    template <typename Type, int numBytes>
+    struct WideRegister
+    {
+        using ElementType = Type;
+        using IntegerType = std::conditional_t<sizeof (Type) == 8, juce::int64, juce::int32>;
+
+        static constexpr int numLanes = numBytes / static_cast<int> (sizeof (Type));
+
+        // typedef rather than using: GCC drops the attribute from an alias of a dependent type
+        typedef Type NativeType __attribute__ ((vector_size (numBytes)));
+        typedef IntegerType IntegerNativeType __attribute__ ((vector_size (numBytes)));
+        typedef juce::int32 LaneIntegers __attribute__ ((vector_size (numLanes * 4))); // One 32 bit integer per lane
+
+        /** All ones in the lanes where a comparison holds. */
+        struct vMaskType
+        {
+            IntegerNativeType value;
+
+            vMaskType operator~() const noexcept    { return { ~value }; }
+        };
+
+        NativeType value;
+
+        //==============================================================================
+        static constexpr size_t size() noexcept    { return static_cast<size_t> (numLanes); }
+
+        static WideRegister expand (Type s) noexcept                  { return { s - NativeType {} }; } // Keeps the sign of zero
+        static WideRegister fromNative (NativeType native) noexcept    { return { native }; }
+
+        static WideRegister fromRawArray (const Type* data) noexcept
+        {
+            WideRegister result;
+            std::memcpy (&result.value, data, sizeof (NativeType));
+            return result;
+        }
+
+        void copyToRawArray (Type* data) const noexcept    { std::memcpy (data, &value, sizeof (NativeType)); }
+
+        static Type* getNextSIMDAlignedPtr (Type* data) noexcept
+        {
+            return reinterpret_cast<Type*> ((reinterpret_cast<juce::pointer_sized_uint> (data) + numBytes - 1) & ~static_cast<juce::pointer_sized_uint> (numBytes - 1));
+        }
+
+        //==============================================================================
+        WideRegister operator+ (WideRegister other) const noexcept    { return { value + other.value }; }
+        WideRegister operator- (WideRegister other) const noexcept    { return { value - other.value }; }
+        WideRegister operator* (WideRegister other) const noexcept    { return { value * other.value }; }
+
+        WideRegister operator+ (Type s) const noexcept    { return { value + s }; }
+        WideRegister operator- (Type s) const noexcept    { return { value - s }; }
+        WideRegister operator* (Type s) const noexcept    { return { value * s }; }
+
+        WideRegister operator& (vMaskType mask) const noexcept    { return { (NativeType) ((IntegerNativeType) value & mask.value) }; }
+
+        //==============================================================================
+        static vMaskType lessThan (WideRegister a, WideRegister b) noexcept       { return { (IntegerNativeType) (a.value < b.value) }; }
+        static vMaskType greaterThan (WideRegister a, WideRegister b) noexcept    { return { (IntegerNativeType) (a.value > b.value) }; }
+
+        /** a where mask is set, b elsewhere, bit for bit. */
+        static WideRegister select (vMaskType mask, WideRegister a, WideRegister b) noexcept
+        {
+            return { (NativeType) (((IntegerNativeType) a.value & mask.value) | ((IntegerNativeType) b.value & ~mask.value)) };
+        }
+
+        // As _mm_min_ps and _mm_max_ps: the second operand unless the first is strictly beyond it
+        static WideRegister min (WideRegister a, WideRegister b) noexcept    { return select (lessThan (a, b), a, b); }
+        static WideRegister max (WideRegister a, WideRegister b) noexcept    { return select (greaterThan (a, b), a, b); }
+
+        static WideRegister abs (WideRegister a) noexcept
+        {
+            return { (NativeType) ((IntegerNativeType) a.value & std::numeric_limits<IntegerType>::max()) };
+        }
+
+        /** Towards zero, through 32 bit integers as SSE2 does for either type. */
+        static WideRegister truncate (WideRegister a) noexcept
+        {
+            return { __builtin_convertvector (__builtin_convertvector (a.value, LaneIntegers), NativeType) };
+        }
+
+        /** 2^n for an integral n in the exponent's range, built in the exponent bits. */
+        static WideRegister exp2Integer (WideRegister n) noexcept
+        {
+            constexpr int mantissaBits = sizeof (Type) == 8 ? 52 : 23;
+            constexpr int bias = sizeof (Type) == 8 ? 1023 : 127;
+
+            const auto biased = __builtin_convertvector (__builtin_convertvector (n.value, LaneIntegers) + bias, IntegerNativeType);
+            return { (NativeType) (biased << mantissaBits) };
+        }
+    };
+
+    //==============================================================================
+    template <typename T, int numBytes> struct ScalarType<WideRegister<T, numBytes>>    { using type = T; };
+
+    template <typename T, int numBytes>
+    struct UnalignedLoad<WideRegister<T, numBytes>>
+    {
+        static WideRegister<T, numBytes> load (const T* data) noexcept    { return WideRegister<T, numBytes>::fromRawArray (data); }
+    };
+
+    // FastMath's register functions, as written for SIMDRegister
+    template <typename T, int numBytes>
+    inline WideRegister<T, numBytes> truncate (WideRegister<T, numBytes> x) noexcept    { return WideRegister<T, numBytes>::truncate (x); }
+
+    template <typename T, int numBytes>
+    inline WideRegister<T, numBytes> abs (WideRegister<T, numBytes> x) noexcept         { return WideRegister<T, numBytes>::abs (x); }
+
+    template <typename T, int numBytes>
+    inline WideRegister<T, numBytes> floor (WideRegister<T, numBytes> x) noexcept
+    {
+        using Register = WideRegister<T, numBytes>;
+        auto t = Register::truncate (x);
+        return t - (Register::expand (T (1)) & Register::lessThan (x, t));
+    }
+
+    template <typename T, int numBytes>
+    inline WideRegister<T, numBytes> clamp (WideRegister<T, numBytes> x, T lo, T hi) noexcept
+    {
+        using Register = WideRegister<T, numBytes>;
+        return Register::max (Register::expand (lo), Register::min (Register::expand (hi), x));
+    }
+
+    template <typename T, int numBytes>
+    inline WideRegister<T, numBytes> clamp (WideRegister<T, numBytes> x, WideRegister<T, numBytes> lo, WideRegister<T, numBytes> hi) noexcept
+    {
+        using Register = WideRegister<T, numBytes>;
+        return Register::max (lo, Register::min (hi, x));
+    }
+
+    template <typename T, int numBytes>
+    inline WideRegister<T, numBytes> exp2Integer (WideRegister<T, numBytes> n) noexcept    { return WideRegister<T, numBytes>::exp2Integer (n); }
+}